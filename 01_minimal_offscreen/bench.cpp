@@ -0,0 +1,313 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+// Headless benchmark for the minimal_offscreen render loop: times each stage
+// of every frame separately and prints min/median/p99 per stage as JSON.
+// Meant to be run in CI, e.g. with QT_QPA_PLATFORM=offscreen and lavapipe or
+// llvmpipe.
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QBuffer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QOffscreenSurface>
+#include <rhi/qrhi.h>
+#include <algorithm>
+
+enum Stage {
+    UpdateStage,
+    RecordStage,
+    WaitStage,
+    ReadbackCopyStage,
+    EncodeStage,
+    StageCount
+};
+
+static const char *stageNames[StageCount] = {
+    "update",
+    "record",
+    "wait",
+    "readback_copy",
+    "encode"
+};
+
+static QJsonObject stageStatistics(std::vector<qint64> nsecs)
+{
+    QJsonObject result;
+    if (nsecs.empty())
+        return result;
+
+    std::sort(nsecs.begin(), nsecs.end());
+    auto percentile = [&nsecs](double p) {
+        const size_t i = qMin(nsecs.size() - 1, size_t(p * (nsecs.size() - 1) + 0.5));
+        return nsecs[i] / 1000.0;
+    };
+    result.insert(QLatin1String("min_us"), nsecs.front() / 1000.0);
+    result.insert(QLatin1String("median_us"), percentile(0.5));
+    result.insert(QLatin1String("p99_us"), percentile(0.99));
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption nullOption({ "n", "null" }, QLatin1String("Null"));
+    cmdLineParser.addOption(nullOption);
+    QCommandLineOption glOption({ "g", "opengl" }, QLatin1String("OpenGL"));
+    cmdLineParser.addOption(glOption);
+    QCommandLineOption vkOption({ "v", "vulkan" }, QLatin1String("Vulkan"));
+    cmdLineParser.addOption(vkOption);
+    QCommandLineOption sizeOption({ "s", "size" }, QLatin1String("Frame size (default 1280x720)"), QLatin1String("WxH"), QLatin1String("1280x720"));
+    cmdLineParser.addOption(sizeOption);
+    QCommandLineOption framesOption({ "f", "frames" }, QLatin1String("Number of measured frames (default 200)"), QLatin1String("count"), QLatin1String("200"));
+    cmdLineParser.addOption(framesOption);
+    QCommandLineOption warmupOption({ "w", "warmup" }, QLatin1String("Number of frames rendered before measuring (default 20)"), QLatin1String("count"), QLatin1String("20"));
+    cmdLineParser.addOption(warmupOption);
+    QCommandLineOption noEncodeOption("no-encode", QLatin1String("Skip the PNG encoding stage"));
+    cmdLineParser.addOption(noEncodeOption);
+    QCommandLineOption cpuFlipOption("cpu-flip", QLatin1String("On Y up backends, flip the frames on the CPU instead of rendering them flipped"));
+    cmdLineParser.addOption(cpuFlipOption);
+    QCommandLineOption outputOption({ "o", "output" }, QLatin1String("Write the JSON results to a file instead of stdout"), QLatin1String("file"));
+    cmdLineParser.addOption(outputOption);
+    cmdLineParser.process(app);
+
+    QRhi::Implementation graphicsApi;
+#if defined(Q_OS_WIN)
+    graphicsApi = QRhi::D3D11;
+#elif QT_CONFIG(metal)
+    graphicsApi = QRhi::Metal;
+#elif QT_CONFIG(vulkan)
+    graphicsApi = QRhi::Vulkan;
+#else
+    graphicsApi = QRhi::OpenGLES2;
+#endif
+    if (cmdLineParser.isSet(nullOption))
+        graphicsApi = QRhi::Null;
+    if (cmdLineParser.isSet(glOption))
+        graphicsApi = QRhi::OpenGLES2;
+    if (cmdLineParser.isSet(vkOption))
+        graphicsApi = QRhi::Vulkan;
+
+    const QStringList sizeStr = cmdLineParser.value(sizeOption).split(QLatin1Char('x'));
+    const QSize outputSize = sizeStr.count() == 2 ? QSize(sizeStr[0].toInt(), sizeStr[1].toInt()) : QSize();
+    if (outputSize.isEmpty())
+        qFatal("Invalid frame size %s", qPrintable(cmdLineParser.value(sizeOption)));
+    const int frameCount = qMax(1, cmdLineParser.value(framesOption).toInt());
+    const int warmupCount = qMax(0, cmdLineParser.value(warmupOption).toInt());
+    const bool encode = !cmdLineParser.isSet(noEncodeOption);
+
+#if QT_CONFIG(vulkan)
+    QVulkanInstance inst;
+#endif
+    std::unique_ptr<QRhi> rhi;
+    std::unique_ptr<QOffscreenSurface> fallbackSurface;
+    if (graphicsApi == QRhi::Null) {
+        QRhiNullInitParams params;
+        rhi.reset(QRhi::create(QRhi::Null, &params));
+    }
+#if defined(Q_OS_WIN)
+    if (graphicsApi == QRhi::D3D11) {
+        QRhiD3D11InitParams params;
+        rhi.reset(QRhi::create(QRhi::D3D11, &params));
+    }
+#endif
+#if QT_CONFIG(metal)
+    if (graphicsApi == QRhi::Metal) {
+        QRhiMetalInitParams params;
+        rhi.reset(QRhi::create(QRhi::Metal, &params));
+    }
+#endif
+#if QT_CONFIG(vulkan)
+    if (graphicsApi == QRhi::Vulkan) {
+        inst.setExtensions(QRhiVulkanInitParams::preferredInstanceExtensions());
+        if (inst.create()) {
+            QRhiVulkanInitParams params;
+            params.inst = &inst;
+            rhi.reset(QRhi::create(QRhi::Vulkan, &params));
+        }
+    }
+#endif
+    if (graphicsApi == QRhi::OpenGLES2) {
+        fallbackSurface.reset(QRhiGles2InitParams::newFallbackSurface());
+        QRhiGles2InitParams params;
+        params.fallbackSurface = fallbackSurface.get();
+        rhi.reset(QRhi::create(QRhi::OpenGLES2, &params));
+    }
+
+    if (!rhi)
+        qFatal("Failed to initialize RHI");
+
+    std::unique_ptr<QRhiTexture> tex(rhi->newTexture(QRhiTexture::RGBA8,
+                                                     outputSize,
+                                                     1,
+                                                     QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource));
+    tex->create();
+    std::unique_ptr<QRhiTextureRenderTarget> rt(rhi->newTextureRenderTarget({ tex.get() }));
+    std::unique_ptr<QRhiRenderPassDescriptor> rp(rt->newCompatibleRenderPassDescriptor());
+    rt->setRenderPassDescriptor(rp.get());
+    rt->create();
+
+    // same as minimal_offscreen: on Y up backends render upside down, so that
+    // the readback data is top row first without a copy, unless --cpu-flip
+    const bool flip = rhi->isYUpInFramebuffer() && cmdLineParser.isSet(cpuFlipOption);
+    QMatrix4x4 viewProjection;
+    if (rhi->isYUpInFramebuffer() && !flip)
+        viewProjection.scale(1.0f, -1.0f, 1.0f);
+    viewProjection *= rhi->clipSpaceCorrMatrix();
+    viewProjection.perspective(45.0f, outputSize.width() / (float) outputSize.height(), 0.01f, 1000.0f);
+    viewProjection.translate(0, 0, -4);
+
+    static float vertexData[] = { // Y up, CCW
+        0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f,     0.0f, 1.0f, 0.0f,
+        0.5f,  -0.5f,     0.0f, 0.0f, 1.0f,
+    };
+
+    std::unique_ptr<QRhiBuffer> vbuf(rhi->newBuffer(QRhiBuffer::Immutable,
+                                                    QRhiBuffer::VertexBuffer,
+                                                    sizeof(vertexData)));
+    vbuf->create();
+
+    std::unique_ptr<QRhiBuffer> ubuf(rhi->newBuffer(QRhiBuffer::Dynamic,
+                                                    QRhiBuffer::UniformBuffer,
+                                                    64));
+    ubuf->create();
+
+    std::unique_ptr<QRhiShaderResourceBindings> srb(rhi->newShaderResourceBindings());
+    srb->setBindings({
+        QRhiShaderResourceBinding::uniformBuffer(0,
+                                                 QRhiShaderResourceBinding::VertexStage,
+                                                 ubuf.get())
+    });
+    srb->create();
+
+    std::unique_ptr<QRhiGraphicsPipeline> ps(rhi->newGraphicsPipeline());
+    static auto getShader = [](const QString &name) {
+        QFile f(name);
+        return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+    };
+    ps->setShaderStages({
+        { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color.vert.qsb")) },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
+    });
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { 5 * sizeof(float) }
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+        { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) }
+    });
+    ps->setVertexInputLayout(inputLayout);
+    ps->setShaderResourceBindings(srb.get());
+    ps->setRenderPassDescriptor(rp.get());
+    ps->create();
+
+    std::vector<qint64> timings[StageCount];
+    for (std::vector<qint64> &t : timings)
+        t.reserve(frameCount);
+
+    float rotation = 0.0f;
+    QElapsedTimer timer;
+    QRhiCommandBuffer *cb;
+    for (int frame = 0; frame < warmupCount + frameCount; ++frame) {
+        const bool measure = frame >= warmupCount;
+        qint64 stageTimes[StageCount] = {};
+
+        rhi->beginOffscreenFrame(&cb);
+
+        timer.start();
+        QRhiResourceUpdateBatch *u = rhi->nextResourceUpdateBatch();
+        if (frame == 0)
+            u->uploadStaticBuffer(vbuf.get(), vertexData);
+        QMatrix4x4 mvp = viewProjection;
+        mvp.rotate(rotation, 0, 1, 0);
+        u->updateDynamicBuffer(ubuf.get(), 0, 64, mvp.constData());
+        rotation += 5.0f;
+        stageTimes[UpdateStage] = timer.nsecsElapsed();
+
+        timer.start();
+        cb->beginPass(rt.get(), Qt::green, { 1.0f, 0 }, u);
+        cb->setGraphicsPipeline(ps.get());
+        cb->setViewport({ 0, 0, float(outputSize.width()), float(outputSize.height()) });
+        cb->setShaderResources();
+        const QRhiCommandBuffer::VertexInput vbufBindings[] = { { vbuf.get(), 0 } };
+        cb->setVertexInput(0, 1, vbufBindings);
+        cb->draw(3);
+        QRhiReadbackResult readbackResult;
+        u = rhi->nextResourceUpdateBatch();
+        u->readBackTexture({ tex.get() }, &readbackResult);
+        cb->endPass(u);
+        stageTimes[RecordStage] = timer.nsecsElapsed();
+
+        // includes the device to host copy of the readback
+        timer.start();
+        rhi->endOffscreenFrame();
+        stageTimes[WaitStage] = timer.nsecsElapsed();
+
+        // What minimal_offscreen's encoder does: wrap the readback data, which
+        // does not copy. Only --cpu-flip copies (mirrors) it on the CPU, so
+        // that is the only case with a readback_copy stage.
+        QImage image(reinterpret_cast<const uchar *>(readbackResult.data.constData()),
+                     readbackResult.pixelSize.width(),
+                     readbackResult.pixelSize.height(),
+                     QImage::Format_RGBA8888);
+        if (flip) {
+            timer.start();
+            image = image.mirrored();
+            stageTimes[ReadbackCopyStage] = timer.nsecsElapsed();
+        }
+
+        if (encode) {
+            // encode into memory, file system performance is not of interest here
+            timer.start();
+            QBuffer buf;
+            buf.open(QIODevice::WriteOnly);
+            image.save(&buf, "PNG");
+            stageTimes[EncodeStage] = timer.nsecsElapsed();
+        }
+
+        if (measure) {
+            for (int s = 0; s < StageCount; ++s) {
+                if ((s != EncodeStage || encode) && (s != ReadbackCopyStage || flip))
+                    timings[s].push_back(stageTimes[s]);
+            }
+        }
+    }
+
+    QJsonObject stages;
+    for (int s = 0; s < StageCount; ++s) {
+        if (!timings[s].empty())
+            stages.insert(QLatin1String(stageNames[s]), stageStatistics(timings[s]));
+    }
+
+    QJsonObject results;
+    results.insert(QLatin1String("backend"), QString::fromLatin1(rhi->backendName()));
+    results.insert(QLatin1String("device"), QString::fromLatin1(rhi->driverInfo().deviceName));
+    results.insert(QLatin1String("size"), QJsonArray { outputSize.width(), outputSize.height() });
+    results.insert(QLatin1String("frames"), frameCount);
+    results.insert(QLatin1String("warmup"), warmupCount);
+    results.insert(QLatin1String("stages"), stages);
+    const QByteArray json = QJsonDocument(results).toJson();
+
+    if (cmdLineParser.isSet(outputOption)) {
+        QFile f(cmdLineParser.value(outputOption));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+            qFatal("Failed to open %s", qPrintable(f.fileName()));
+        f.write(json);
+    } else {
+        QFile f;
+        f.open(stdout, QIODevice::WriteOnly);
+        f.write(json);
+    }
+
+    return 0;
+}
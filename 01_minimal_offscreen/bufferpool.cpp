@@ -0,0 +1,23 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "bufferpool.h"
+
+QByteArray ReadbackBufferPool::acquire()
+{
+    // The returned buffer must not be referenced by the pool, otherwise it
+    // would be shared, and QRhi would detach (allocate) when writing into it.
+    for (qsizetype i = 0; i < m_buffers.count(); ++i) {
+        if (m_buffers[i].isDetached())
+            return m_buffers.takeAt(i);
+    }
+
+    // An empty QByteArray, QRhi performs the actual allocation.
+    ++m_allocationCount;
+    return QByteArray();
+}
+
+void ReadbackBufferPool::release(QByteArray buffer)
+{
+    m_buffers.append(std::move(buffer));
+}
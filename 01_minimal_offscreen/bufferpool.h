@@ -0,0 +1,29 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <QByteArray>
+#include <QList>
+
+// Recycles the QByteArrays that receive the readback data. QRhi writes the
+// data in place when the QByteArray it gets is not shared and is large enough,
+// otherwise it allocates. Frames handed to a consumer (e.g. the encoder
+// threads) keep sharing the buffer until they are done, so the pool keeps a
+// reference to each buffer it gave out, and a buffer becomes available again
+// once the pool's reference is the only one left.
+class ReadbackBufferPool
+{
+public:
+    QByteArray acquire();
+    void release(QByteArray buffer);
+
+    int allocationCount() const { return m_allocationCount; }
+
+private:
+    QList<QByteArray> m_buffers;
+    int m_allocationCount = 0;
+};
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "frameencoder.h"
+#include <QImage>
+
+FrameEncoder::FrameEncoder(int threadCount, int maxQueuedFrames)
+    : m_maxQueuedFrames(qMax(1, maxQueuedFrames))
+{
+    for (int i = 0; i < qMax(1, threadCount); ++i) {
+        QThread *t = QThread::create([this] { run(); });
+        t->start();
+        m_threads.append(t);
+    }
+}
+
+FrameEncoder::~FrameEncoder()
+{
+    finish();
+}
+
+void FrameEncoder::enqueue(int frame, const QByteArray &data, qsizetype offset, const QSize &pixelSize, bool flip)
+{
+    // This function is invoked on the render loop's thread. data is
+    // implicitly shared, queuing it does not copy the pixels. The frame starts
+    // at offset, so that one readback can hold multiple frames.
+
+    QMutexLocker lock(&m_mutex);
+    while (m_queue.count() >= m_maxQueuedFrames)
+        m_slotAvailable.wait(&m_mutex);
+
+    m_queue.enqueue({ frame, data, offset, pixelSize, flip });
+    m_jobAvailable.wakeOne();
+}
+
+void FrameEncoder::finish()
+{
+    // Waits until all queued frames are written out.
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_finishing = true;
+        m_jobAvailable.wakeAll();
+    }
+
+    for (QThread *t : std::as_const(m_threads)) {
+        t->wait();
+        delete t;
+    }
+    m_threads.clear();
+}
+
+void FrameEncoder::run()
+{
+    // This function is invoked on the worker threads.
+
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (m_queue.isEmpty() && !m_finishing)
+                m_jobAvailable.wait(&m_mutex);
+            if (m_queue.isEmpty())
+                return;
+            job = m_queue.dequeue();
+            m_slotAvailable.wakeOne();
+        }
+
+        QImage image(reinterpret_cast<const uchar *>(job.data.constData() + job.offset),
+                     job.pixelSize.width(),
+                     job.pixelSize.height(),
+                     QImage::Format_RGBA8888);
+        // Wrapping the data in a QImage does not copy, but mirroring does.
+        if (job.flip) {
+            image = image.mirrored();
+            m_frameCopyCount.fetchAndAddRelaxed(1);
+        }
+        image.save(QString::asprintf("frame%d.png", job.frame));
+    }
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef FRAMEENCODER_H
+#define FRAMEENCODER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QQueue>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+
+// Takes the raw readback data of frames from the render loop and does the
+// (optional) vertical flip and the PNG encoding on a pool of worker threads.
+// The queue is bounded: enqueue() blocks when maxQueuedFrames frames are
+// already waiting, so a slow encoder cannot make memory usage grow without
+// limits. The file name only depends on the frame number, so the output is the
+// same no matter in which order the workers finish.
+class FrameEncoder
+{
+public:
+    FrameEncoder(int threadCount, int maxQueuedFrames);
+    ~FrameEncoder();
+
+    void enqueue(int frame, const QByteArray &data, qsizetype offset, const QSize &pixelSize, bool flip);
+    void finish();
+
+    int threadCount() const { return m_threads.count(); }
+    int frameCopyCount() const { return m_frameCopyCount.loadRelaxed(); }
+
+private:
+    struct Job {
+        int frame;
+        QByteArray data;
+        qsizetype offset;
+        QSize pixelSize;
+        bool flip;
+    };
+
+    void run();
+
+    QMutex m_mutex;
+    QWaitCondition m_jobAvailable;
+    QWaitCondition m_slotAvailable;
+    QQueue<Job> m_queue;
+    int m_maxQueuedFrames;
+    bool m_finishing = false;
+    QList<QThread *> m_threads;
+    QAtomicInt m_frameCopyCount;
+};
+
+#endif
@@ -0,0 +1,111 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "framestream.h"
+#include "yuv.h"
+#include <cstdio>
+#include <cstring>
+
+bool FrameStreamWriter::open(const QString &fileName, Format format, const QSize &pixelSize)
+{
+    m_format = format;
+    m_pixelSize = pixelSize;
+
+    // Unbuffered, because all writes are large anyway, there is nothing to
+    // gain from going through QFile's own buffer.
+    bool ok;
+    if (fileName == QLatin1String("-")) {
+        ok = m_file.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    } else {
+        m_file.setFileName(fileName);
+        ok = m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered);
+    }
+    if (!ok)
+        return false;
+
+    if (m_format == Y4M) {
+        // the frame rate is nominal, there is no real time involved here
+        const QByteArray header = QByteArray("YUV4MPEG2 W") + QByteArray::number(pixelSize.width())
+            + " H" + QByteArray::number(pixelSize.height())
+            + " F30:1 Ip A1:1 C420jpeg\n";
+        writeBlock(header.constData(), header.size());
+        m_staging.resize(i420Size(pixelSize.width(), pixelSize.height()));
+    }
+
+    return true;
+}
+
+void FrameStreamWriter::writeFrame(const char *rgba, bool flip)
+{
+    const int w = m_pixelSize.width();
+    const int h = m_pixelSize.height();
+
+    if (m_format == Y4M) {
+        static const char frameHeader[] = "FRAME\n";
+        writeBlock(frameHeader, sizeof(frameHeader) - 1);
+        rgbaToI420(reinterpret_cast<const uchar *>(rgba), w, h, flip,
+                   reinterpret_cast<uchar *>(m_staging.data()));
+        writeBlock(m_staging.constData(), i420Size(w, h));
+        return;
+    }
+
+    writePlane(rgba, qsizetype(w) * 4, h, flip);
+    if (flip)
+        ++m_frameCopyCount;
+}
+
+void FrameStreamWriter::writeI420Frame(const char *y, const char *u, const char *v, bool flip)
+{
+    const int w = m_pixelSize.width();
+    const int h = m_pixelSize.height();
+
+    if (m_format == Y4M) {
+        static const char frameHeader[] = "FRAME\n";
+        writeBlock(frameHeader, sizeof(frameHeader) - 1);
+    }
+
+    writePlane(y, w, h, flip);
+    writePlane(u, (w + 1) / 2, (h + 1) / 2, flip);
+    writePlane(v, (w + 1) / 2, (h + 1) / 2, flip);
+    if (flip)
+        ++m_frameCopyCount;
+}
+
+void FrameStreamWriter::writePlane(const char *data, qsizetype bytesPerLine, int rows, bool flip)
+{
+    if (!flip) {
+        writeBlock(data, bytesPerLine * rows);
+        return;
+    }
+
+    // The rows have to go out in reverse order. Gather them into a reusable
+    // staging buffer so that this still results in a few large writes, not
+    // one per row.
+    const int rowsPerChunk = qMax(1, int((4 * 1024 * 1024) / bytesPerLine));
+    if (m_staging.size() < rowsPerChunk * bytesPerLine)
+        m_staging.resize(rowsPerChunk * bytesPerLine);
+    for (int y = rows - 1; y >= 0; ) {
+        int n = 0;
+        for (; n < rowsPerChunk && y >= 0; ++n, --y)
+            memcpy(m_staging.data() + n * bytesPerLine, data + y * bytesPerLine, bytesPerLine);
+        writeBlock(m_staging.constData(), n * bytesPerLine);
+    }
+}
+
+void FrameStreamWriter::close()
+{
+    m_file.close();
+}
+
+void FrameStreamWriter::writeBlock(const char *data, qsizetype size)
+{
+    while (size > 0) {
+        const qint64 written = m_file.write(data, size);
+        if (written <= 0) {
+            qWarning("Failed to write output: %s", qPrintable(m_file.errorString()));
+            return;
+        }
+        data += written;
+        size -= written;
+    }
+}
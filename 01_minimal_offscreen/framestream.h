@@ -0,0 +1,43 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef FRAMESTREAM_H
+#define FRAMESTREAM_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSize>
+
+// Streams all frames into a single file (or stdout), either as raw RGBA8 or as
+// YUV4MPEG2 (Y4M) with 4:2:0 chroma subsampling. The file is opened once, and
+// each frame goes out with as few and as large writes as possible, straight
+// from the readback data. Frames that were already converted to I420 on the
+// GPU are written as-is (raw I420 in case of the RawRgba format).
+class FrameStreamWriter
+{
+public:
+    enum Format {
+        RawRgba,
+        Y4M
+    };
+
+    bool open(const QString &fileName, Format format, const QSize &pixelSize);
+    void writeFrame(const char *rgba, bool flip);
+    void writeI420Frame(const char *y, const char *u, const char *v, bool flip);
+    void close();
+
+    QString errorString() const { return m_file.errorString(); }
+    int frameCopyCount() const { return m_frameCopyCount; }
+
+private:
+    void writePlane(const char *data, qsizetype bytesPerLine, int rows, bool flip);
+    void writeBlock(const char *data, qsizetype size);
+
+    QFile m_file;
+    Format m_format = RawRgba;
+    QSize m_pixelSize;
+    QByteArray m_staging;
+    int m_frameCopyCount = 0;
+};
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "gpuyuv.h"
+#include <QFile>
+
+bool GpuYuvConverter::isSupported(QRhi *rhi)
+{
+    return rhi->isTextureFormatSupported(QRhiTexture::R8)
+        && rhi->resourceLimit(QRhi::MaxColorAttachments) >= 2;
+}
+
+bool GpuYuvConverter::create(QRhi *rhi, const QList<QRhiTexture *> &sources)
+{
+    m_rhi = rhi;
+
+    m_sampler.reset(m_rhi->newSampler(QRhiSampler::Nearest, QRhiSampler::Nearest, QRhiSampler::None,
+                                      QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge));
+    if (!m_sampler->create())
+        return false;
+
+    m_targets.clear();
+    m_targets.resize(sources.count());
+    for (int i = 0; i < sources.count(); ++i) {
+        Target &t(m_targets[i]);
+        const QSize size = sources[i]->pixelSize();
+        const QSize chromaSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+        for (int p = 0; p < PlaneCount; ++p) {
+            t.planes[p].reset(m_rhi->newTexture(QRhiTexture::R8,
+                                                p == PlaneY ? size : chromaSize,
+                                                1,
+                                                QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource));
+            if (!t.planes[p]->create())
+                return false;
+        }
+
+        t.yRt.reset(m_rhi->newTextureRenderTarget({ t.planes[PlaneY].get() }));
+        QRhiTextureRenderTargetDescription uvDesc;
+        uvDesc.setColorAttachments({ QRhiColorAttachment(t.planes[PlaneU].get()),
+                                     QRhiColorAttachment(t.planes[PlaneV].get()) });
+        t.uvRt.reset(m_rhi->newTextureRenderTarget(uvDesc));
+        if (i == 0) {
+            m_yRp.reset(t.yRt->newCompatibleRenderPassDescriptor());
+            m_uvRp.reset(t.uvRt->newCompatibleRenderPassDescriptor());
+        }
+        t.yRt->setRenderPassDescriptor(m_yRp.get());
+        t.uvRt->setRenderPassDescriptor(m_uvRp.get());
+        if (!t.yRt->create() || !t.uvRt->create())
+            return false;
+
+        t.srb.reset(m_rhi->newShaderResourceBindings());
+        t.srb->setBindings({
+            QRhiShaderResourceBinding::sampledTexture(0, QRhiShaderResourceBinding::FragmentStage,
+                                                      sources[i], m_sampler.get())
+        });
+        if (!t.srb->create())
+            return false;
+    }
+
+    static auto getShader = [](const QString &name) {
+        QFile f(name);
+        return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+    };
+    const QShader vs = getShader(QLatin1String(":/shaders/yuv.vert.qsb"));
+
+    m_yPipeline.reset(m_rhi->newGraphicsPipeline());
+    m_yPipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, vs },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/yuv_y.frag.qsb")) }
+    });
+    m_yPipeline->setShaderResourceBindings(m_targets[0].srb.get());
+    m_yPipeline->setRenderPassDescriptor(m_yRp.get());
+    if (!m_yPipeline->create())
+        return false;
+
+    m_uvPipeline.reset(m_rhi->newGraphicsPipeline());
+    m_uvPipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, vs },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/yuv_uv.frag.qsb")) }
+    });
+    // one blend state per color attachment
+    m_uvPipeline->setTargetBlends({ QRhiGraphicsPipeline::TargetBlend(), QRhiGraphicsPipeline::TargetBlend() });
+    m_uvPipeline->setShaderResourceBindings(m_targets[0].srb.get());
+    m_uvPipeline->setRenderPassDescriptor(m_uvRp.get());
+    return m_uvPipeline->create();
+}
+
+void GpuYuvConverter::convert(QRhiCommandBuffer *cb, int sourceIndex)
+{
+    // Records the two passes, must be called after the pass rendering into
+    // the source texture, within the same frame.
+
+    Target &t(m_targets[sourceIndex]);
+
+    const QSize size = t.planes[PlaneY]->pixelSize();
+    cb->beginPass(t.yRt.get(), Qt::black, { 1.0f, 0 });
+    cb->setGraphicsPipeline(m_yPipeline.get());
+    cb->setViewport({ 0, 0, float(size.width()), float(size.height()) });
+    cb->setShaderResources(t.srb.get());
+    cb->draw(3);
+    QRhiResourceUpdateBatch *u = m_rhi->nextResourceUpdateBatch();
+    u->readBackTexture({ t.planes[PlaneY].get() }, &t.readbackResults[PlaneY]);
+    cb->endPass(u);
+
+    const QSize chromaSize = t.planes[PlaneU]->pixelSize();
+    cb->beginPass(t.uvRt.get(), Qt::black, { 1.0f, 0 });
+    cb->setGraphicsPipeline(m_uvPipeline.get());
+    cb->setViewport({ 0, 0, float(chromaSize.width()), float(chromaSize.height()) });
+    cb->setShaderResources(t.srb.get());
+    cb->draw(3);
+    u = m_rhi->nextResourceUpdateBatch();
+    u->readBackTexture({ t.planes[PlaneU].get() }, &t.readbackResults[PlaneU]);
+    u->readBackTexture({ t.planes[PlaneV].get() }, &t.readbackResults[PlaneV]);
+    cb->endPass(u);
+}
@@ -0,0 +1,51 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef GPUYUV_H
+#define GPUYUV_H
+
+#include <rhi/qrhi.h>
+
+// Converts RGBA8 textures to I420 on the GPU, and reads back only the three
+// planes: 1.5 bytes per pixel instead of 4. The Y plane is written by one
+// pass, the half-size U and V planes by a second pass with two color
+// attachments. There is one set of plane textures and readbacks per source
+// texture, so that multiple frames can be converted within the same offscreen
+// frame.
+class GpuYuvConverter
+{
+public:
+    enum Plane {
+        PlaneY,
+        PlaneU,
+        PlaneV,
+        PlaneCount
+    };
+
+    static bool isSupported(QRhi *rhi);
+
+    bool create(QRhi *rhi, const QList<QRhiTexture *> &sources);
+    void convert(QRhiCommandBuffer *cb, int sourceIndex);
+
+    // valid after the frame in which convert() was called has completed
+    const QRhiReadbackResult &plane(int sourceIndex, Plane plane) const { return m_targets[sourceIndex].readbackResults[plane]; }
+
+private:
+    struct Target {
+        std::unique_ptr<QRhiTexture> planes[PlaneCount];
+        std::unique_ptr<QRhiTextureRenderTarget> yRt;
+        std::unique_ptr<QRhiTextureRenderTarget> uvRt;
+        std::unique_ptr<QRhiShaderResourceBindings> srb;
+        QRhiReadbackResult readbackResults[PlaneCount];
+    };
+
+    QRhi *m_rhi = nullptr;
+    std::unique_ptr<QRhiSampler> m_sampler;
+    std::unique_ptr<QRhiRenderPassDescriptor> m_yRp;
+    std::unique_ptr<QRhiRenderPassDescriptor> m_uvRp;
+    std::unique_ptr<QRhiGraphicsPipeline> m_yPipeline;
+    std::unique_ptr<QRhiGraphicsPipeline> m_uvPipeline;
+    std::vector<Target> m_targets;
+};
+
+#endif
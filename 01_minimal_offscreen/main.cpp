@@ -2,39 +2,213 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include <QGuiApplication>
-#include <QImage>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
 #include <QOffscreenSurface>
+#include <QStandardPaths>
 #include <rhi/qrhi.h>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+#include "bufferpool.h"
+#include "frameencoder.h"
+#include "framestream.h"
+#include "gpuyuv.h"
+#include "yuv.h"
+
+// Everything needed to render one frame into its own texture. With more than
+// one of these, consecutive frames use them round-robin, so that a number of
+// frames can be recorded and submitted before having to wait for the results.
+// In batched mode the texture is an atlas: a column of tiles, each holding a
+// complete frame, and the uniform buffer has one (aligned) matrix per tile.
+struct FrameSlot
+{
+    std::unique_ptr<QRhiTexture> tex;
+    std::unique_ptr<QRhiTextureRenderTarget> rt;
+    std::unique_ptr<QRhiBuffer> ubuf;
+    std::unique_ptr<QRhiShaderResourceBindings> srb;
+    QRhiReadbackResult readbackResult;
+};
+
+// Pipeline cache file: a magic and a version of our own, then QRhi's data.
+// The file name separates the devices; a driver update needs nothing here,
+// QRhi ignores data created with a different driver when loading it.
+static const quint32 PIPELINE_CACHE_MAGIC = 0x50435254; // "TRCP"
+static const quint32 PIPELINE_CACHE_VERSION = 1;
+
+static QString pipelineCacheFileName(QRhi *rhi)
+{
+    const QRhiDriverInfo driverInfo = rhi->driverInfo();
+    const QByteArray driverKey = QCryptographicHash::hash(driverInfo.deviceName
+                                                          + QByteArray::number(driverInfo.deviceId)
+                                                          + QByteArray::number(driverInfo.vendorId),
+                                                          QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QLatin1String("/pipelinecache_") + QString::fromLatin1(rhi->backendName()).toLower()
+        + QLatin1Char('_') + QString::fromLatin1(driverKey) + QLatin1String(".bin");
+}
+
+static bool loadPipelineCache(QRhi *rhi)
+{
+    // must be called before creating any graphics pipelines
+    QFile f(pipelineCacheFileName(rhi));
+    if (!f.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray contents = f.readAll();
+    quint32 header[2];
+    if (contents.size() <= qsizetype(sizeof(header)))
+        return false;
+    memcpy(header, contents.constData(), sizeof(header));
+    if (header[0] != PIPELINE_CACHE_MAGIC || header[1] != PIPELINE_CACHE_VERSION)
+        return false;
+
+    rhi->setPipelineCacheData(contents.mid(sizeof(header)));
+    return true;
+}
+
+static void savePipelineCache(QRhi *rhi)
+{
+    const QByteArray data = rhi->pipelineCacheData();
+    if (data.isEmpty())
+        return;
+
+    const QString fileName = pipelineCacheFileName(rhi);
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Failed to write pipeline cache to %s", qPrintable(fileName));
+        return;
+    }
+    const quint32 header[2] = { PIPELINE_CACHE_MAGIC, PIPELINE_CACHE_VERSION };
+    f.write(reinterpret_cast<const char *>(header), sizeof(header));
+    f.write(data);
+}
+
+static qint64 peakResidentSetSize()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_DARWIN
+        return usage.ru_maxrss;
+#else
+        return qint64(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return -1;
+}
+
+static int maxDifference(const QByteArray &plane, const uchar *reference)
+{
+    int result = 0;
+    for (qsizetype i = 0; i < plane.size(); ++i)
+        result = qMax(result, qAbs(int(uchar(plane[i])) - int(reference[i])));
+    return result;
+}
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption framesOption({ "f", "frames" }, QLatin1String("Number of frames to render (default 20)"), QLatin1String("count"), QLatin1String("20"));
+    cmdLineParser.addOption(framesOption);
+    QCommandLineOption inFlightOption("in-flight", QLatin1String("Number of frames recorded and submitted before waiting for their readbacks (default 1)"), QLatin1String("count"), QLatin1String("1"));
+    cmdLineParser.addOption(inFlightOption);
+    QCommandLineOption noSaveOption("no-save", QLatin1String("Do not save the frames to image files"));
+    cmdLineParser.addOption(noSaveOption);
+    QCommandLineOption encodeThreadsOption("encode-threads", QLatin1String("Number of image encoder threads (default: number of CPU cores)"), QLatin1String("count"),
+                                           QString::number(QThread::idealThreadCount()));
+    cmdLineParser.addOption(encodeThreadsOption);
+    QCommandLineOption maxQueuedOption("max-queued", QLatin1String("Maximum number of frames waiting to be encoded before the render loop blocks (default: 2 per encoder thread)"), QLatin1String("count"));
+    cmdLineParser.addOption(maxQueuedOption);
+    QCommandLineOption outputOption({ "o", "output" }, QLatin1String("Stream all frames into a single file instead of writing PNG files, - for stdout"), QLatin1String("file"));
+    cmdLineParser.addOption(outputOption);
+    QCommandLineOption formatOption("format", QLatin1String("Format for --output: raw (RGBA8) or y4m (default raw)"), QLatin1String("format"), QLatin1String("raw"));
+    cmdLineParser.addOption(formatOption);
+    QCommandLineOption gpuYuvOption("gpu-yuv", QLatin1String("Convert to I420 on the GPU and read back only the YUV planes (needs --output)"));
+    cmdLineParser.addOption(gpuYuvOption);
+    QCommandLineOption verifyYuvOption("verify-yuv", QLatin1String("With --gpu-yuv, also read back the RGBA data and compare the planes with the CPU conversion"));
+    cmdLineParser.addOption(verifyYuvOption);
+    QCommandLineOption glOption({ "g", "opengl" }, QLatin1String("Use OpenGL instead of the platform's default 3D API"));
+    cmdLineParser.addOption(glOption);
+    QCommandLineOption cpuFlipOption("cpu-flip", QLatin1String("On Y up backends, flip the frames on the CPU instead of rendering them flipped"));
+    cmdLineParser.addOption(cpuFlipOption);
+    QCommandLineOption sizeOption({ "s", "size" }, QLatin1String("Frame size (default 1280x720)"), QLatin1String("WxH"), QLatin1String("1280x720"));
+    cmdLineParser.addOption(sizeOption);
+    QCommandLineOption batchOption({ "b", "batch" }, QLatin1String("Number of frames rendered as tiles into one texture and read back at once (default 1)"), QLatin1String("count"), QLatin1String("1"));
+    cmdLineParser.addOption(batchOption);
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame, and if the pipeline cache was used"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption statsOption("stats", QLatin1String("Print memory and copy statistics at the end"));
+    cmdLineParser.addOption(statsOption);
+    cmdLineParser.process(app);
+
+    const int frameCount = qMax(1, cmdLineParser.value(framesOption).toInt());
+    const int inFlight = qMax(1, cmdLineParser.value(inFlightOption).toInt());
+    const bool save = !cmdLineParser.isSet(noSaveOption);
+    const int encodeThreads = qMax(1, cmdLineParser.value(encodeThreadsOption).toInt());
+    const int maxQueued = cmdLineParser.isSet(maxQueuedOption) ? cmdLineParser.value(maxQueuedOption).toInt()
+                                                              : 2 * encodeThreads;
+    const QString outputFileName = cmdLineParser.value(outputOption);
+    FrameStreamWriter::Format streamFormat = FrameStreamWriter::RawRgba;
+    if (cmdLineParser.value(formatOption) == QLatin1String("y4m"))
+        streamFormat = FrameStreamWriter::Y4M;
+    else if (cmdLineParser.value(formatOption) != QLatin1String("raw"))
+        qFatal("Unknown output format %s", qPrintable(cmdLineParser.value(formatOption)));
+    bool gpuYuv = cmdLineParser.isSet(gpuYuvOption);
+    bool verifyYuv = gpuYuv && cmdLineParser.isSet(verifyYuvOption);
+    if (gpuYuv && save && outputFileName.isEmpty())
+        qFatal("--gpu-yuv is only supported together with --output or --no-save");
+    const bool forceOpenGL = cmdLineParser.isSet(glOption);
+    const QStringList sizeStr = cmdLineParser.value(sizeOption).split(QLatin1Char('x'));
+    const QSize outputSize = sizeStr.count() == 2 ? QSize(sizeStr[0].toInt(), sizeStr[1].toInt()) : QSize();
+    if (outputSize.isEmpty())
+        qFatal("Invalid frame size %s", qPrintable(cmdLineParser.value(sizeOption)));
+    int tilesPerSlot = qMax(1, cmdLineParser.value(batchOption).toInt());
+    if (gpuYuv && tilesPerSlot > 1 && (outputSize.height() % 2))
+        qFatal("--gpu-yuv with --batch needs an even frame height");
+
 #if QT_CONFIG(vulkan)
     QVulkanInstance inst;
 #endif
     std::unique_ptr<QRhi> rhi;
     std::unique_ptr<QOffscreenSurface> fallbackSurface;
+    // so that pipelineCacheData() has something to return on all backends
+    const QRhi::Flags rhiFlags = QRhi::EnablePipelineCacheDataSave;
 #if defined(Q_OS_WIN)
-    QRhiD3D11InitParams params;
-    rhi.reset(QRhi::create(QRhi::D3D11, &params));
+    if (!forceOpenGL) {
+        QRhiD3D11InitParams params;
+        rhi.reset(QRhi::create(QRhi::D3D11, &params, rhiFlags));
+    }
 #elif defined(Q_OS_MACOS) || defined(Q_OS_IOS)
-    QRhiMetalInitParams params;
-    rhi.reset(QRhi::create(QRhi::Metal, &params));
+    if (!forceOpenGL) {
+        QRhiMetalInitParams params;
+        rhi.reset(QRhi::create(QRhi::Metal, &params, rhiFlags));
+    }
 #elif QT_CONFIG(vulkan)
     inst.setExtensions(QRhiVulkanInitParams::preferredInstanceExtensions());
-    if (inst.create()) {
+    if (!forceOpenGL && inst.create()) {
         QRhiVulkanInitParams params;
         params.inst = &inst;
-        rhi.reset(QRhi::create(QRhi::Vulkan, &params));
+        rhi.reset(QRhi::create(QRhi::Vulkan, &params, rhiFlags));
     }
 #endif
     if (!rhi) {
         fallbackSurface.reset(QRhiGles2InitParams::newFallbackSurface());
         QRhiGles2InitParams params;
         params.fallbackSurface = fallbackSurface.get();
-        rhi.reset(QRhi::create(QRhi::OpenGLES2, &params));
+        rhi.reset(QRhi::create(QRhi::OpenGLES2, &params, rhiFlags));
     }
 
     if (rhi)
@@ -42,20 +216,63 @@ int main(int argc, char **argv)
     else
         qFatal("Failed to initialize RHI");
 
+    const bool pipelineCacheLoaded = loadPipelineCache(rhi.get());
+
     float rotation = 0.0f;
 
-    std::unique_ptr<QRhiTexture> tex(rhi->newTexture(QRhiTexture::RGBA8,
-                                                     QSize(1280, 720),
-                                                     1,
-                                                     QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource));
-    tex->create();
-    std::unique_ptr<QRhiTextureRenderTarget> rt(rhi->newTextureRenderTarget({ tex.get() }));
-    std::unique_ptr<QRhiRenderPassDescriptor> rp(rt->newCompatibleRenderPassDescriptor());
-    rt->setRenderPassDescriptor(rp.get());
-    rt->create();
-
-    QMatrix4x4 viewProjection = rhi->clipSpaceCorrMatrix();
-    viewProjection.perspective(45.0f, 1280 / 720.f, 0.01f, 1000.0f);
+    const int maxTilesPerSlot = qMax(1, rhi->resourceLimit(QRhi::TextureSizeMax) / outputSize.height());
+    if (tilesPerSlot > maxTilesPerSlot) {
+        qWarning("Batch size limited to %d by the maximum texture size", maxTilesPerSlot);
+        tilesPerSlot = maxTilesPerSlot;
+    }
+    const QSize slotSize(outputSize.width(), outputSize.height() * tilesPerSlot);
+    const qsizetype tileBytes = qsizetype(outputSize.width()) * outputSize.height() * 4;
+
+    std::vector<FrameSlot> slots(inFlight);
+    for (FrameSlot &slot : slots) {
+        slot.tex.reset(rhi->newTexture(QRhiTexture::RGBA8,
+                                       slotSize,
+                                       1,
+                                       QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource));
+        slot.tex->create();
+        slot.rt.reset(rhi->newTextureRenderTarget({ slot.tex.get() }));
+    }
+
+    // all the render targets are identical, so one renderpass descriptor is
+    // enough, and the pipeline is then compatible with all of them
+    std::unique_ptr<QRhiRenderPassDescriptor> rp(slots[0].rt->newCompatibleRenderPassDescriptor());
+    for (FrameSlot &slot : slots) {
+        slot.rt->setRenderPassDescriptor(rp.get());
+        slot.rt->create();
+    }
+
+    std::unique_ptr<GpuYuvConverter> yuvConverter;
+    if (gpuYuv) {
+        if (GpuYuvConverter::isSupported(rhi.get())) {
+            QList<QRhiTexture *> sources;
+            for (FrameSlot &slot : slots)
+                sources.append(slot.tex.get());
+            yuvConverter.reset(new GpuYuvConverter);
+            if (!yuvConverter->create(rhi.get(), sources))
+                qFatal("Failed to create resources for the GPU-side YUV conversion");
+        } else {
+            qWarning("GPU-side YUV conversion is not supported, reading back RGBA data instead");
+            gpuYuv = false;
+            verifyYuv = false;
+        }
+    }
+
+    // On backends where the framebuffer is Y up (OpenGL), the first row in the
+    // readback data is the bottom one. Rather than flipping every frame on the
+    // CPU, which is a full copy, render upside down by flipping Y in clip
+    // space. Then the data can go to the encoder or the output file as-is. (no
+    // culling is enabled, so the changed winding order does not matter)
+    const bool flip = rhi->isYUpInFramebuffer() && cmdLineParser.isSet(cpuFlipOption);
+    QMatrix4x4 viewProjection;
+    if (rhi->isYUpInFramebuffer() && !flip)
+        viewProjection.scale(1.0f, -1.0f, 1.0f);
+    viewProjection *= rhi->clipSpaceCorrMatrix();
+    viewProjection.perspective(45.0f, outputSize.width() / (float) outputSize.height(), 0.01f, 1000.0f);
     viewProjection.translate(0, 0, -4);
 
     static float vertexData[] = { // Y up, CCW
@@ -69,18 +286,26 @@ int main(int argc, char **argv)
                                                     sizeof(vertexData)));
     vbuf->create();
 
-    std::unique_ptr<QRhiBuffer> ubuf(rhi->newBuffer(QRhiBuffer::Dynamic,
-                                                    QRhiBuffer::UniformBuffer,
-                                                    64));
-    ubuf->create();
+    // Each frame within a batch needs its own uniform data: a Dynamic buffer
+    // updated multiple times within the same frame would see only the last
+    // update in all the draw calls. Tiles within a slot use different regions
+    // of the same buffer, selected with a dynamic offset when drawing.
+    const quint32 ubufStride = rhi->ubufAligned(64);
+    for (FrameSlot &slot : slots) {
+        slot.ubuf.reset(rhi->newBuffer(QRhiBuffer::Dynamic,
+                                       QRhiBuffer::UniformBuffer,
+                                       ubufStride * tilesPerSlot));
+        slot.ubuf->create();
 
-    std::unique_ptr<QRhiShaderResourceBindings> srb(rhi->newShaderResourceBindings());
-    srb->setBindings({
-        QRhiShaderResourceBinding::uniformBuffer(0,
-                                                 QRhiShaderResourceBinding::VertexStage,
-                                                 ubuf.get())
-    });
-    srb->create();
+        slot.srb.reset(rhi->newShaderResourceBindings());
+        slot.srb->setBindings({
+            QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(0,
+                                                                      QRhiShaderResourceBinding::VertexStage,
+                                                                      slot.ubuf.get(),
+                                                                      64)
+        });
+        slot.srb->create();
+    }
 
     std::unique_ptr<QRhiGraphicsPipeline> ps(rhi->newGraphicsPipeline());
     static auto getShader = [](const QString &name) {
@@ -100,44 +325,168 @@ int main(int argc, char **argv)
         { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) }
     });
     ps->setVertexInputLayout(inputLayout);
-    ps->setShaderResourceBindings(srb.get());
+    ps->setShaderResourceBindings(slots[0].srb.get()); // layout-compatible with all the others
     ps->setRenderPassDescriptor(rp.get());
     ps->create();
 
+    // endOffscreenFrame() always submits and then waits for the GPU to
+    // complete, there is no way to have an offscreen frame in flight while
+    // recording the next one. What we can do instead is to record up to
+    // inFlight frames, each targeting its own texture and having its own
+    // readback, into the same offscreen frame, so the GPU can work on them
+    // back to back, and the CPU waits only once per batch.
+    // With --batch, each of those textures receives tilesPerSlot frames, each
+    // rendered with a viewport covering one tile, and still read back with a
+    // single readback. This matters most with small frame sizes, where the
+    // fixed per-pass, per-readback, and per-submission costs dominate.
+    // Flipping and PNG compression is done on a pool of worker threads, while
+    // the loop here moves on to the next batch.
+    //
+    // Alternatively, with --output, everything goes into a single file,
+    // written directly from the readback data, on this thread, in order.
+    std::unique_ptr<FrameEncoder> encoder;
+    std::unique_ptr<FrameStreamWriter> stream;
+    if (save && !outputFileName.isEmpty()) {
+        stream.reset(new FrameStreamWriter);
+        if (!stream->open(outputFileName, streamFormat, outputSize))
+            qFatal("Failed to open %s: %s", qPrintable(outputFileName), qPrintable(stream->errorString()));
+    } else if (save) {
+        encoder.reset(new FrameEncoder(encodeThreads, maxQueued));
+    }
+
+    ReadbackBufferPool readbackPool;
+    int yuvMaxDifference = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
     QRhiCommandBuffer *cb;
-    for (int frame = 0; frame < 20; ++frame) {
+    const int framesPerSlot = tilesPerSlot;
+    const int framesPerBatch = inFlight * framesPerSlot;
+    for (int firstFrame = 0; firstFrame < frameCount; firstFrame += framesPerBatch) {
+        const int slotCount = qMin(inFlight, (frameCount - firstFrame + framesPerSlot - 1) / framesPerSlot);
+
         rhi->beginOffscreenFrame(&cb);
 
-        QRhiResourceUpdateBatch *u = rhi->nextResourceUpdateBatch();
-        if (frame == 0)
-            u->uploadStaticBuffer(vbuf.get(), vertexData);
-
-        QMatrix4x4 mvp = viewProjection;
-        mvp.rotate(rotation, 0, 1, 0);
-        u->updateDynamicBuffer(ubuf.get(), 0, 64, mvp.constData());
-        rotation += 5.0f;
-
-        cb->beginPass(rt.get(), Qt::green, { 1.0f, 0 }, u);
-        cb->setGraphicsPipeline(ps.get());
-        cb->setViewport({ 0, 0, 1280, 720 });
-        cb->setShaderResources();
-        const QRhiCommandBuffer::VertexInput vbufBindings[] = { { vbuf.get(), 0 } };
-        cb->setVertexInput(0, 1, vbufBindings);
-        cb->draw(3);
-        QRhiReadbackResult readbackResult;
-        u = rhi->nextResourceUpdateBatch();
-        u->readBackTexture({ tex.get() }, &readbackResult);
-        cb->endPass(u);
+        for (int i = 0; i < slotCount; ++i) {
+            FrameSlot &slot(slots[i]);
+            const int slotFirstFrame = firstFrame + i * framesPerSlot;
+            const int tileCount = qMin(framesPerSlot, frameCount - slotFirstFrame);
+
+            QRhiResourceUpdateBatch *u = rhi->nextResourceUpdateBatch();
+            if (slotFirstFrame == 0)
+                u->uploadStaticBuffer(vbuf.get(), vertexData);
+
+            for (int t = 0; t < tileCount; ++t) {
+                QMatrix4x4 mvp = viewProjection;
+                mvp.rotate(rotation, 0, 1, 0);
+                u->updateDynamicBuffer(slot.ubuf.get(), t * ubufStride, 64, mvp.constData());
+                rotation += 5.0f;
+            }
+
+            cb->beginPass(slot.rt.get(), Qt::green, { 1.0f, 0 }, u);
+            cb->setGraphicsPipeline(ps.get());
+            const QRhiCommandBuffer::VertexInput vbufBindings[] = { { vbuf.get(), 0 } };
+            cb->setVertexInput(0, 1, vbufBindings);
+            for (int t = 0; t < tileCount; ++t) {
+                // Viewports are bottom-left based, regardless of the backend.
+                // Place tile t so that it ends up in rows [t * h, (t + 1) * h)
+                // of the readback data, which is bottom row first on Y up
+                // backends, top row first otherwise.
+                const int h = outputSize.height();
+                const int y = rhi->isYUpInFramebuffer() ? t * h : (tilesPerSlot - 1 - t) * h;
+                cb->setViewport({ 0, float(y), float(outputSize.width()), float(h) });
+                const QRhiCommandBuffer::DynamicOffset dynamicOffset = { 0, quint32(t * ubufStride) };
+                cb->setShaderResources(slot.srb.get(), 1, &dynamicOffset);
+                cb->draw(3);
+            }
+            if (!gpuYuv || verifyYuv) {
+                slot.readbackResult.data = readbackPool.acquire();
+                u = rhi->nextResourceUpdateBatch();
+                u->readBackTexture({ slot.tex.get() }, &slot.readbackResult);
+                cb->endPass(u);
+            } else {
+                cb->endPass();
+            }
+
+            if (gpuYuv)
+                yuvConverter->convert(cb, i);
+        }
 
         rhi->endOffscreenFrame();
 
-        QImage image(reinterpret_cast<const uchar *>(readbackResult.data.constData()),
-                     readbackResult.pixelSize.width(),
-                     readbackResult.pixelSize.height(),
-                     QImage::Format_RGBA8888);
-        if (rhi->isYUpInFramebuffer())
-            image = image.mirrored();
-        image.save(QString::asprintf("frame%d.png", frame));
+        if (firstFrame == 0 && cmdLineParser.isSet(reportStartupOption)) {
+            qDebug("Time to first frame: %lld ms (pipeline cache %s)", startupTimer.elapsed(),
+                   pipelineCacheLoaded ? "warm" : "cold");
+        }
+
+        if (verifyYuv) {
+            for (int i = 0; i < slotCount; ++i) {
+                const QRhiReadbackResult &readbackResult(slots[i].readbackResult);
+                const int w = readbackResult.pixelSize.width();
+                const int h = readbackResult.pixelSize.height();
+                QByteArray reference(i420Size(w, h), Qt::Uninitialized);
+                const uchar *ref = reinterpret_cast<const uchar *>(reference.constData());
+                rgbaToI420(reinterpret_cast<const uchar *>(readbackResult.data.constData()), w, h, false,
+                           reinterpret_cast<uchar *>(reference.data()));
+                const qsizetype chromaSize = qsizetype((w + 1) / 2) * ((h + 1) / 2);
+                yuvMaxDifference = qMax(yuvMaxDifference, maxDifference(yuvConverter->plane(i, GpuYuvConverter::PlaneY).data, ref));
+                yuvMaxDifference = qMax(yuvMaxDifference, maxDifference(yuvConverter->plane(i, GpuYuvConverter::PlaneU).data, ref + qsizetype(w) * h));
+                yuvMaxDifference = qMax(yuvMaxDifference, maxDifference(yuvConverter->plane(i, GpuYuvConverter::PlaneV).data, ref + qsizetype(w) * h + chromaSize));
+            }
+        }
+
+        for (int i = 0; i < slotCount; ++i) {
+            QRhiReadbackResult &readbackResult(slots[i].readbackResult);
+            const int slotFirstFrame = firstFrame + i * framesPerSlot;
+            const int tileCount = qMin(framesPerSlot, frameCount - slotFirstFrame);
+            // Each tile is a contiguous range within the readback data, so
+            // splitting the frames needs no copying either.
+            for (int t = 0; save && t < tileCount; ++t) {
+                if (gpuYuv) {
+                    const qsizetype yTileBytes = tileBytes / 4;
+                    const qsizetype chromaTileBytes = qsizetype((outputSize.width() + 1) / 2) * ((outputSize.height() + 1) / 2);
+                    stream->writeI420Frame(yuvConverter->plane(i, GpuYuvConverter::PlaneY).data.constData() + t * yTileBytes,
+                                           yuvConverter->plane(i, GpuYuvConverter::PlaneU).data.constData() + t * chromaTileBytes,
+                                           yuvConverter->plane(i, GpuYuvConverter::PlaneV).data.constData() + t * chromaTileBytes,
+                                           flip);
+                } else if (stream) {
+                    stream->writeFrame(readbackResult.data.constData() + t * tileBytes, flip);
+                } else {
+                    encoder->enqueue(slotFirstFrame + t, readbackResult.data, t * tileBytes, outputSize, flip);
+                }
+            }
+            // the encoder may still be using it, the pool knows when it is free
+            if (!readbackResult.data.isNull())
+                readbackPool.release(std::move(readbackResult.data));
+        }
+    }
+
+    if (encoder)
+        encoder->finish();
+    if (stream)
+        stream->close();
+
+    const qint64 elapsed = timer.elapsed();
+    qDebug("%d frames of %dx%d with %d in flight, %d per texture: %lld ms, %.1f frames/sec",
+           frameCount, outputSize.width(), outputSize.height(), inFlight, tilesPerSlot,
+           elapsed, frameCount * 1000.0 / qMax<qint64>(1, elapsed));
+
+    savePipelineCache(rhi.get());
+
+    if (cmdLineParser.isSet(statsOption)) {
+        const int frameCopies = (encoder ? encoder->frameCopyCount() : 0) + (stream ? stream->frameCopyCount() : 0);
+        qDebug("Peak resident set size: %lld KB", peakResidentSetSize() / 1024);
+        qDebug("Readback buffer allocations: %d", readbackPool.allocationCount());
+        qDebug("Full-frame copies on the CPU: %d", frameCopies);
+    }
+
+    if (verifyYuv) {
+        // allow for the GPU rounding differently from the CPU reference
+        const int tolerance = 2;
+        qDebug("GPU YUV conversion: max difference from the CPU reference is %d", yuvMaxDifference);
+        if (yuvMaxDifference > tolerance)
+            return 1;
     }
 
     return 0;
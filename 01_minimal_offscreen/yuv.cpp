@@ -0,0 +1,51 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "yuv.h"
+#include <cmath>
+
+static inline uchar toByte(float v)
+{
+    return uchar(qBound(0.0f, std::round(v), 255.0f));
+}
+
+void rgbaToI420(const uchar *rgba, int width, int height, bool flip, uchar *dst)
+{
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    uchar *yPlane = dst;
+    uchar *uPlane = yPlane + qsizetype(width) * height;
+    uchar *vPlane = uPlane + qsizetype(chromaWidth) * chromaHeight;
+
+    auto row = [=](int y) {
+        return rgba + qsizetype(flip ? height - 1 - y : y) * width * 4;
+    };
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *src = row(y);
+        uchar *yDst = yPlane + qsizetype(y) * width;
+        for (int x = 0; x < width; ++x) {
+            const float r = src[x * 4] / 255.0f;
+            const float g = src[x * 4 + 1] / 255.0f;
+            const float b = src[x * 4 + 2] / 255.0f;
+            yDst[x] = toByte(16.0f + 65.481f * r + 128.553f * g + 24.966f * b);
+        }
+    }
+
+    // chroma is the average of each 2x2 block (clamped at the edges)
+    for (int cy = 0; cy < chromaHeight; ++cy) {
+        const uchar *src0 = row(cy * 2);
+        const uchar *src1 = row(qMin(cy * 2 + 1, height - 1));
+        uchar *uDst = uPlane + qsizetype(cy) * chromaWidth;
+        uchar *vDst = vPlane + qsizetype(cy) * chromaWidth;
+        for (int cx = 0; cx < chromaWidth; ++cx) {
+            const int x0 = cx * 2 * 4;
+            const int x1 = qMin(cx * 2 + 1, width - 1) * 4;
+            const float r = (src0[x0] + src0[x1] + src1[x0] + src1[x1]) / (4 * 255.0f);
+            const float g = (src0[x0 + 1] + src0[x1 + 1] + src1[x0 + 1] + src1[x1 + 1]) / (4 * 255.0f);
+            const float b = (src0[x0 + 2] + src0[x1 + 2] + src1[x0 + 2] + src1[x1 + 2]) / (4 * 255.0f);
+            uDst[cx] = toByte(128.0f - 37.797f * r - 74.203f * g + 112.0f * b);
+            vDst[cx] = toByte(128.0f + 112.0f * r - 93.786f * g - 18.214f * b);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef YUV_H
+#define YUV_H
+
+#include <QtGlobal>
+
+// Size of an I420 (planar YUV 4:2:0, U plane followed by V plane) image.
+inline qsizetype i420Size(int width, int height)
+{
+    const qsizetype chromaSize = qsizetype((width + 1) / 2) * ((height + 1) / 2);
+    return qsizetype(width) * height + 2 * chromaSize;
+}
+
+// Converts tightly packed RGBA8 to I420 on the CPU, using BT.601 limited range
+// coefficients. When flip is true, the rows of the source are taken bottom to
+// top. dst must be able to hold i420Size(width, height) bytes.
+void rgbaToI420(const uchar *rgba, int width, int height, bool flip, uchar *dst);
+
+#endif
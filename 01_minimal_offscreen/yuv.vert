@@ -0,0 +1,8 @@
+#version 440
+
+void main()
+{
+    // fullscreen triangle, no vertex inputs needed
+    vec2 pos = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 440
+
+layout(location = 0) out vec4 uColor;
+layout(location = 1) out vec4 vColor;
+
+layout(binding = 0) uniform sampler2D src;
+
+// BT.601 limited range, must match rgbaToI420() in yuv.cpp
+
+void main()
+{
+    // average of the corresponding 2x2 block, clamped at the edges
+    ivec2 p0 = ivec2(gl_FragCoord.xy) * 2;
+    ivec2 p1 = min(p0 + ivec2(1), textureSize(src, 0) - ivec2(1));
+    vec3 c = (texelFetch(src, p0, 0).rgb
+              + texelFetch(src, ivec2(p1.x, p0.y), 0).rgb
+              + texelFetch(src, ivec2(p0.x, p1.y), 0).rgb
+              + texelFetch(src, p1, 0).rgb) * 0.25;
+    float u = 128.0 - 37.797 * c.r - 74.203 * c.g + 112.0 * c.b;
+    float v = 128.0 + 112.0 * c.r - 93.786 * c.g - 18.214 * c.b;
+    uColor = vec4(u / 255.0, 0.0, 0.0, 1.0);
+    vColor = vec4(v / 255.0, 0.0, 0.0, 1.0);
+}
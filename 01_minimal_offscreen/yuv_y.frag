@@ -0,0 +1,16 @@
+#version 440
+
+layout(location = 0) out vec4 fragColor;
+
+layout(binding = 0) uniform sampler2D src;
+
+// BT.601 limited range, must match rgbaToI420() in yuv.cpp
+
+void main()
+{
+    // same row order as the source texture on every backend, so the planes
+    // need flipping exactly when the RGBA data would
+    vec3 c = texelFetch(src, ivec2(gl_FragCoord.xy), 0).rgb;
+    float y = 16.0 + 65.481 * c.r + 128.553 * c.g + 24.966 * c.b;
+    fragColor = vec4(y / 255.0, 0.0, 0.0, 1.0);
+}
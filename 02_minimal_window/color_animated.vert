@@ -0,0 +1,32 @@
+#version 440
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 color;
+layout(location = 2) in vec2 instOffset;
+layout(location = 3) in vec2 instScaleRotation; // rotation in radians
+
+layout(location = 0) out vec3 v_color;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 viewProjection;
+    float time;
+    float dt;
+    uint count;
+};
+
+void main()
+{
+    v_color = color;
+    float s = sin(instScaleRotation.y);
+    float c = cos(instScaleRotation.y);
+    vec2 p = mat2(c, s, -s, c) * position.xy * instScaleRotation.x;
+    // the whole grid rotates around Y by 60 degrees per second
+    float a = radians(time * 60.0);
+    float sa = sin(a);
+    float ca = cos(a);
+    mat4 rotation = mat4(ca, 0.0, -sa, 0.0,
+                         0.0, 1.0, 0.0, 0.0,
+                         sa, 0.0, ca, 0.0,
+                         0.0, 0.0, 0.0, 1.0);
+    gl_Position = viewProjection * rotation * vec4(p + instOffset, 0.0, 1.0);
+}
@@ -0,0 +1,104 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "frametimings.h"
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+
+const char *FrameTimings::metricName(Metric metric)
+{
+    switch (metric) {
+    case FrameInterval:
+        return "frame";
+    case BeginFrameWait:
+        return "beginFrame wait";
+    case CpuRecord:
+        return "CPU record";
+    case GpuTime:
+        return "GPU";
+    case Latency:
+        return "latency";
+    default:
+        break;
+    }
+    return "";
+}
+
+void FrameTimings::addSample(const Sample &sample)
+{
+    m_window[m_windowPos] = sample;
+    m_windowPos = (m_windowPos + 1) % WINDOW_SIZE;
+    m_windowCount = qMin(m_windowCount + 1, WINDOW_SIZE);
+    if (m_historyEnabled)
+        m_history.append(sample);
+}
+
+FrameTimings::Summary FrameTimings::summary(Metric metric) const
+{
+    Summary result;
+
+    // For these a 0 means not available (no timestamps, not yet completed, or
+    // no animation state sampled), not a fast frame.
+    const bool skipZero = metric == GpuTime || metric == Latency;
+
+    // the order does not matter, the values get sorted
+    std::array<float, WINDOW_SIZE> values;
+    int count = 0;
+    for (int i = 0; i < m_windowCount; ++i) {
+        const float v = m_window[i][metric];
+        if (!skipZero || v > 0.0f)
+            values[count++] = v;
+    }
+    if (count == 0)
+        return result;
+
+    std::sort(values.begin(), values.begin() + count);
+
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i)
+        sum += values[i];
+
+    result.min = values[0];
+    result.avg = sum / count;
+    result.p95 = values[int(0.95 * (count - 1) + 0.5)];
+    result.p99 = values[int(0.99 * (count - 1) + 0.5)];
+    result.count = count;
+    return result;
+}
+
+QString FrameTimings::summaryText() const
+{
+    QString text;
+    for (int m = 0; m < MetricCount; ++m) {
+        const Summary s = summary(Metric(m));
+        if (!text.isEmpty())
+            text += QLatin1String(" | ");
+        if (s.count == 0)
+            text += QString::asprintf("%s n/a", metricName(Metric(m)));
+        else
+            text += QString::asprintf("%s min %.2f avg %.2f p95 %.2f p99 %.2f ms",
+                                      metricName(Metric(m)), s.min, s.avg, s.p95, s.p99);
+    }
+    return text;
+}
+
+bool FrameTimings::saveCsv(const QString &fileName) const
+{
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&f);
+    out << "frame";
+    for (int m = 0; m < MetricCount; ++m)
+        out << ',' << QString::fromLatin1(metricName(Metric(m))).replace(QLatin1Char(' '), QLatin1Char('_')) << "_ms";
+    out << '\n';
+    for (qsizetype i = 0; i < m_history.count(); ++i) {
+        out << i;
+        for (int m = 0; m < MetricCount; ++m)
+            out << ',' << m_history[i][m];
+        out << '\n';
+    }
+    return true;
+}
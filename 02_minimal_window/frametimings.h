@@ -0,0 +1,58 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef FRAMETIMINGS_H
+#define FRAMETIMINGS_H
+
+#include <QList>
+#include <QString>
+#include <array>
+
+// Collects per-frame timings. Statistics are calculated over a rolling window
+// of the most recent frames, kept in a fixed-size ring. All samples are kept
+// only when the history is enabled, for the CSV dump.
+class FrameTimings
+{
+public:
+    enum Metric {
+        FrameInterval,      // time since the previous frame started
+        BeginFrameWait,     // time blocked in beginFrame()
+        CpuRecord,          // time from beginFrame() returning to endFrame()
+        GpuTime,            // QRhiCommandBuffer::lastCompletedGpuTime(), for an earlier frame, 0 if not available
+        Latency,            // time from sampling the animation state to endFrame() returning, 0 if not sampled
+        MetricCount
+    };
+
+    using Sample = std::array<float, MetricCount>; // in milliseconds
+
+    struct Summary {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        int count = 0; // samples that went into it, 0 means n/a
+    };
+
+    static const char *metricName(Metric metric);
+
+    void setHistoryEnabled(bool enable) { m_historyEnabled = enable; }
+    bool isHistoryEnabled() const { return m_historyEnabled; }
+
+    void addSample(const Sample &sample);
+    static int windowSize() { return WINDOW_SIZE; }
+
+    Summary summary(Metric metric) const;
+    QString summaryText() const;
+
+    bool saveCsv(const QString &fileName) const;
+
+private:
+    static const int WINDOW_SIZE = 240;
+    std::array<Sample, WINDOW_SIZE> m_window;
+    int m_windowCount = 0;
+    int m_windowPos = 0; // where the next sample goes
+    bool m_historyEnabled = false;
+    QList<Sample> m_history;
+};
+
+#endif
@@ -3,17 +3,90 @@
 
 #include <QGuiApplication>
 #include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
+#include <QKeyEvent>
+#include <QStandardPaths>
+#include <QtMath>
 #include <QWindow>
 #include <QOffscreenSurface>
 #include <QPlatformSurfaceEvent>
 #include <rhi/qrhi.h>
+#include <cmath>
+#include <cstdio>
+#include "frametimings.h"
+#include "memoryusage.h"
+#include "meshfile.h"
+#include "meshstreamer.h"
+#include "simulation.h"
+#include "transforms.h"
+#include "uniformring.h"
+
+// same pipeline cache file format as in minimal_offscreen
+static const quint32 PIPELINE_CACHE_MAGIC = 0x50435254; // "TRCP"
+static const quint32 PIPELINE_CACHE_VERSION = 1;
+
+static QString pipelineCacheFileName(QRhi *rhi)
+{
+    const QRhiDriverInfo driverInfo = rhi->driverInfo();
+    const QByteArray driverKey = QCryptographicHash::hash(driverInfo.deviceName
+                                                          + QByteArray::number(driverInfo.deviceId)
+                                                          + QByteArray::number(driverInfo.vendorId),
+                                                          QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QLatin1String("/pipelinecache_") + QString::fromLatin1(rhi->backendName()).toLower()
+        + QLatin1Char('_') + QString::fromLatin1(driverKey) + QLatin1String(".bin");
+}
+
+// Animation speed of each instance, in radians per second. Must match
+// animate.comp.
+static inline float instanceSpeed(int i)
+{
+    return 0.5f + (i % 8) * 0.25f;
+}
 
 class HelloWindow : public QWindow
 {
 public:
+    enum InstanceAnimation {
+        NoAnimation,        // static instances, the MVP is updated every frame
+        CpuAnimation,       // the instance buffer is rewritten every frame
+        GpuAnimation        // a compute shader updates the instance buffer
+    };
+
+    enum ObjectUniforms {
+        RingUniforms,       // one buffer and srb, with dynamic offsets
+        SeparateUniforms    // one buffer and srb per object
+    };
+
     HelloWindow(QRhi::Implementation graphicsApi);
     void releaseSwapChain();
+    void savePipelineCache();
+    void setStartupTimer(const QElapsedTimer &timer) { m_startupTimer = timer; m_reportStartup = true; }
+    void setTimingReportEnabled(bool enable) { m_timingReport = enable; }
+    void setTimingHistoryEnabled(bool enable) { m_timings.setHistoryEnabled(enable); }
+    const FrameTimings &frameTimings() const { return m_timings; }
+    void setInstanceCount(int count) { m_instanceCount = count; }
+    void setInstanceSweepEnabled(bool enable) { m_instanceSweep = enable; }
+    void setInstanceAnimation(InstanceAnimation animation) { m_instanceAnimation = animation; }
+    void setAnimationBenchmarkEnabled(bool enable);
+    void setObjectCount(int count, ObjectUniforms uniforms) { m_objectCount = count; m_objectUniforms = uniforms; }
+    void setObjectsBenchmarkEnabled(bool enable);
+    void setSwapChainFlags(QRhiSwapChain::Flags flags) { m_swapChainFlags = flags; }
+    void setWaitForGpuEnabled(bool enable) { m_waitForGpu = enable; }
+    void setLatchMode(bool timeBased, bool late) { m_timeBasedRotation = timeBased; m_lateLatch = late; }
+    void setOnDemandEnabled(bool enable) { m_onDemand = enable; }
+    void setAnimating(bool animating);
+    quint64 framesRendered() const { return m_framesRendered; }
+    quint64 framesNeeded() const { return m_framesNeeded; }
+    void setSimulationEnabled(bool threaded, int costMs) { m_simulationEnabled = true; m_simulationThreaded = threaded; m_simulationCost = costMs; }
+    void setMeshFile(const QString &fileName, MeshFile::OpenMode mode) { m_meshFileName = fileName; m_meshOpenMode = mode; }
+    void setMeshBenchmarkEnabled(bool enable) { m_meshBenchmark = enable; }
+    void setMeshStreamingBudget(quint64 bytesPerFrame) { m_meshStreamingBudget = bytesPerFrame; }
 
 private:
 #if QT_CONFIG(opengl)
@@ -34,11 +107,27 @@ private:
     bool m_newlyExposed = false;
     QMatrix4x4 m_viewProjection;
 
+    bool m_pipelineCacheLoaded = false;
+    bool m_reportStartup = false;
+    QElapsedTimer m_startupTimer;
+
+    FrameTimings m_timings;
+    bool m_timingReport = false;
+    QElapsedTimer m_timingReportTimer;
+    QElapsedTimer m_frameIntervalTimer;
+
     void init();
+    void loadPipelineCache();
+    void createInstanceBuffer();
+    void createComputeAnimation();
+    void createObjects();
+    void advanceObjectsBenchmark();
+    void advanceInstanceSweep();
     void resizeSwapChain();
     void render();
 
     void exposeEvent(QExposeEvent *) override;
+    void keyPressEvent(QKeyEvent *) override;
     bool event(QEvent *) override;
 
     std::unique_ptr<QRhiBuffer> m_vbuf;
@@ -47,8 +136,133 @@ private:
     std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
     QRhiResourceUpdateBatch *m_initialUpdates = nullptr;
     float m_rotation = 0.0f;
+
+    // stress mode: m_instanceCount instances of the triangle with one draw call
+    int m_instanceCount = 0;
+    bool m_instanceSweep = false;
+    int m_instanceSweepFrame = 0;
+    int m_instanceSweepMax = 10000000;
+    std::unique_ptr<QRhiBuffer> m_instanceBuf;
+    std::unique_ptr<QRhiGraphicsPipeline> m_instancedPipeline;
+
+    // animated instances, see InstanceAnimation
+    InstanceAnimation m_instanceAnimation = NoAnimation;
+    bool m_animationBenchmark = false;
+    QElapsedTimer m_animationTimer;
+    float m_animationTime = 0.0f;
+    QByteArray m_instanceData; // CpuAnimation only
+    bool m_viewProjectionChanged = true;
+    std::unique_ptr<QRhiBuffer> m_animationUbuf;
+    std::unique_ptr<QRhiShaderResourceBindings> m_animationSrb;
+    std::unique_ptr<QRhiGraphicsPipeline> m_animatedPipeline;
+    std::unique_ptr<QRhiShaderResourceBindings> m_computeSrb;
+    std::unique_ptr<QRhiComputePipeline> m_computePipeline;
+
+    // m_objectCount triangles, each with its own draw call and uniform data
+    int m_objectCount = 0;
+    ObjectUniforms m_objectUniforms = RingUniforms;
+    bool m_objectsBenchmark = false;
+    int m_objectsBenchmarkFrame = 0;
+    qint64 m_objectsSetupTime = 0;
+    ObjectTransforms m_objects;
+    UniformRing m_uniformRing;
+    std::unique_ptr<QRhiShaderResourceBindings> m_ringSrb;
+    std::unique_ptr<QRhiGraphicsPipeline> m_ringPipeline;
+    struct ObjectResources {
+        std::unique_ptr<QRhiBuffer> ubuf;
+        std::unique_ptr<QRhiShaderResourceBindings> srb;
+    };
+    std::vector<ObjectResources> m_objectResources;
+    QByteArray m_objectMvps;
+
+    // the rotation and the matrices come from a Simulation, possibly running
+    // on a worker thread, instead of being calculated in render()
+    bool m_simulationEnabled = false;
+    bool m_simulationThreaded = false;
+    int m_simulationCost = 0;
+    std::unique_ptr<Simulation> m_simulation;
+
+    void createSimulation();
+
+    // latency
+    QRhiSwapChain::Flags m_swapChainFlags;
+    bool m_waitForGpu = false;
+    bool m_timeBasedRotation = false;
+    bool m_lateLatch = false;
+    qint64 m_sampleTime = 0;
+    void sampleRotation();
+
+    // On demand: the rotation is time based, and a new frame is requested
+    // only while animating, otherwise only exposes (including resizes) lead
+    // to rendering. Space toggles the animation.
+    bool m_onDemand = false;
+    bool m_animating = true;
+    bool m_dirty = true;
+    QElapsedTimer m_onDemandTimer;
+    // a frame is needed when the animation is running or something else
+    // (size, exposure) changed since the previous one
+    quint64 m_framesRendered = 0;
+    quint64 m_framesNeeded = 0;
+    bool isAnimating() const;
+    void uploadSimulationState(QRhiResourceUpdateBatch *resourceUpdates);
+
+    // an indexed mesh loaded from a file (see meshgen) instead of the triangle
+    QString m_meshFileName;
+    MeshFile::OpenMode m_meshOpenMode = MeshFile::Map;
+    std::unique_ptr<QRhiBuffer> m_meshVbuf;
+    std::unique_ptr<QRhiBuffer> m_meshIbuf;
+    std::unique_ptr<QRhiGraphicsPipeline> m_meshPipeline;
+    QRhiCommandBuffer::IndexFormat m_meshIndexFormat = QRhiCommandBuffer::IndexUInt16;
+    quint32 m_meshIndexCount = 0;
+    QElapsedTimer m_meshLoadTimer;
+    qint64 m_meshLoadTime = 0;
+    bool m_reportMesh = false;
+    bool m_meshBenchmark = false;
+
+    // With a budget, the mesh is uploaded over multiple frames, and drawn
+    // as far as it is available, instead of all in the first frame. The file
+    // stays open (mapped) until then.
+    quint64 m_meshStreamingBudget = 0;
+    std::unique_ptr<MeshFile> m_meshFile;
+    MeshStreamer m_meshStreamer;
+    int m_meshStreamingFrames = 0;
+    qint64 m_meshStreamingTime = 0;
+    qint64 m_meshStreamingMaxTime = 0;
+    void streamMesh(QRhiResourceUpdateBatch *resourceUpdates);
+
+    bool createMesh(QRhiShaderResourceBindings *srb, const QShader &vs, const QShader &fs);
 };
 
+// Benchmarks the CPU frame cost of animating 1K, 10K, 100K, and 1M instances
+// on the CPU, then with the compute shader.
+static const int ANIMATION_BENCHMARK_START = 1000;
+static const int ANIMATION_BENCHMARK_MAX = 1000000;
+
+// Benchmarks 100, 1K, and 10K draw calls with the uniform ring, then with one
+// uniform buffer and srb per object.
+static const int OBJECTS_BENCHMARK_START = 100;
+static const int OBJECTS_BENCHMARK_MAX = 10000;
+
+void HelloWindow::setObjectsBenchmarkEnabled(bool enable)
+{
+    m_objectsBenchmark = enable;
+    if (enable) {
+        m_objectCount = OBJECTS_BENCHMARK_START;
+        m_objectUniforms = RingUniforms;
+    }
+}
+
+void HelloWindow::setAnimationBenchmarkEnabled(bool enable)
+{
+    m_animationBenchmark = enable;
+    if (enable) {
+        m_instanceSweep = true;
+        m_instanceSweepMax = ANIMATION_BENCHMARK_MAX;
+        m_instanceCount = ANIMATION_BENCHMARK_START;
+        m_instanceAnimation = CpuAnimation;
+    }
+}
+
 HelloWindow::HelloWindow(QRhi::Implementation graphicsApi)
     : m_graphicsApi(graphicsApi)
 {
@@ -73,6 +287,9 @@ HelloWindow::HelloWindow(QRhi::Implementation graphicsApi)
 
 void HelloWindow::exposeEvent(QExposeEvent *)
 {
+    if (isExposed())
+        m_dirty = true;
+
     if (isExposed() && !m_initialized) {
         init();
         resizeSwapChain();
@@ -114,9 +331,13 @@ bool HelloWindow::event(QEvent *e)
 
 void HelloWindow::init()
 {
+    // so that pipelineCacheData() has something to return on all backends,
+    // and so that lastCompletedGpuTime() reports GPU timings
+    const QRhi::Flags rhiFlags = QRhi::EnablePipelineCacheDataSave | QRhi::EnableTimestamps;
+
     if (m_graphicsApi == QRhi::Null) {
         QRhiNullInitParams params;
-        m_rhi.reset(QRhi::create(QRhi::Null, &params));
+        m_rhi.reset(QRhi::create(QRhi::Null, &params, rhiFlags));
     }
 
 #if QT_CONFIG(opengl)
@@ -125,7 +346,7 @@ void HelloWindow::init()
         QRhiGles2InitParams params;
         params.fallbackSurface = m_fallbackSurface.get();
         params.window = this;
-        m_rhi.reset(QRhi::create(QRhi::OpenGLES2, &params));
+        m_rhi.reset(QRhi::create(QRhi::OpenGLES2, &params, rhiFlags));
     }
 #endif
 
@@ -134,7 +355,7 @@ void HelloWindow::init()
         QRhiVulkanInitParams params;
         params.inst = vulkanInstance();
         params.window = this;
-        m_rhi.reset(QRhi::create(QRhi::Vulkan, &params));
+        m_rhi.reset(QRhi::create(QRhi::Vulkan, &params, rhiFlags));
     }
 #endif
 
@@ -142,30 +363,36 @@ void HelloWindow::init()
     if (m_graphicsApi == QRhi::D3D11) {
         QRhiD3D11InitParams params;
         params.enableDebugLayer = true;
-        m_rhi.reset(QRhi::create(QRhi::D3D11, &params));
+        m_rhi.reset(QRhi::create(QRhi::D3D11, &params, rhiFlags));
     } else if (m_graphicsApi == QRhi::D3D12) {
         QRhiD3D12InitParams params;
         params.enableDebugLayer = true;
-        m_rhi.reset(QRhi::create(QRhi::D3D12, &params));
+        m_rhi.reset(QRhi::create(QRhi::D3D12, &params, rhiFlags));
     }
 #endif
 
 #if QT_CONFIG(metal)
     if (m_graphicsApi == QRhi::Metal) {
         QRhiMetalInitParams params;
-        m_rhi.reset(QRhi::create(QRhi::Metal, &params));
+        m_rhi.reset(QRhi::create(QRhi::Metal, &params, rhiFlags));
     }
 #endif
 
     if (!m_rhi)
         qFatal("Failed to create RHI backend");
 
+    // Before creating any pipelines. With a warm cache, the shader
+    // compilation and pipeline creation below is much cheaper, and so the
+    // first frame arrives earlier.
+    loadPipelineCache();
+
     m_sc.reset(m_rhi->newSwapChain());
     m_ds.reset(m_rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil,
                                       QSize(),
                                       1,
                                       QRhiRenderBuffer::UsedWithSwapChainOnly));
     m_sc->setWindow(this);
+    m_sc->setFlags(m_swapChainFlags);
     m_sc->setDepthStencil(m_ds.get());
     m_rp.reset(m_sc->newCompatibleRenderPassDescriptor());
     m_sc->setRenderPassDescriptor(m_rp.get());
@@ -214,11 +441,545 @@ void HelloWindow::init()
 
         m_initialUpdates = m_rhi->nextResourceUpdateBatch();
         m_initialUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
+
+        if (!m_meshFileName.isEmpty()) {
+            if (m_instanceCount > 0 || m_objectCount > 0 || m_objectsBenchmark)
+                qWarning("The mesh is not used with instancing or objects");
+            else
+                createMesh(m_srb.get(), m_pipeline->shaderStageAt(0).shader(), m_pipeline->shaderStageAt(1).shader());
+        }
+
+        if (m_instanceCount > 0 && !m_rhi->isFeatureSupported(QRhi::Instancing)) {
+            qWarning("Instancing is not supported, drawing a single triangle");
+            m_instanceCount = 0;
+            m_instanceSweep = false;
+            m_instanceAnimation = NoAnimation;
+            m_animationBenchmark = false;
+        }
+
+        const bool computeSupported = m_rhi->isFeatureSupported(QRhi::Compute);
+        if (m_instanceAnimation == GpuAnimation && !computeSupported) {
+            qWarning("Compute is not supported, animating the instances on the CPU");
+            m_instanceAnimation = CpuAnimation;
+        }
+        if (m_animationBenchmark && !computeSupported)
+            qWarning("Compute is not supported, benchmarking CPU animation only");
+
+        if (m_instanceCount > 0) {
+            // Same as the other pipeline, but with a second, per-instance
+            // vertex input binding.
+            m_instancedPipeline.reset(m_rhi->newGraphicsPipeline());
+            m_instancedPipeline->setShaderStages({
+                { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color_instanced.vert.qsb")) },
+                { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
+            });
+            QRhiVertexInputLayout instancedInputLayout;
+            instancedInputLayout.setBindings({
+                { 5 * sizeof(float) },
+                { 4 * sizeof(float), QRhiVertexInputBinding::PerInstance }
+            });
+            instancedInputLayout.setAttributes({
+                { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+                { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) },
+                { 1, 2, QRhiVertexInputAttribute::Float2, 0 },                 // offset
+                { 1, 3, QRhiVertexInputAttribute::Float2, 2 * sizeof(float) }  // scale, rotation
+            });
+            m_instancedPipeline->setVertexInputLayout(instancedInputLayout);
+            m_instancedPipeline->setShaderResourceBindings(m_srb.get());
+            m_instancedPipeline->setRenderPassDescriptor(m_rp.get());
+            m_instancedPipeline->create();
+
+            if (m_instanceAnimation == GpuAnimation || (m_animationBenchmark && computeSupported))
+                createComputeAnimation();
+
+            createInstanceBuffer();
+        }
+
+        if (m_objectCount > 0) {
+            createObjects();
+
+            // A uniform buffer with a dynamic offset is not the same layout
+            // as a plain one, so this needs a pipeline of its own.
+            if (m_ringSrb) {
+                m_ringPipeline.reset(m_rhi->newGraphicsPipeline());
+                m_ringPipeline->setShaderStages(m_pipeline->cbeginShaderStages(), m_pipeline->cendShaderStages());
+                m_ringPipeline->setVertexInputLayout(m_pipeline->vertexInputLayout());
+                m_ringPipeline->setShaderResourceBindings(m_ringSrb.get());
+                m_ringPipeline->setRenderPassDescriptor(m_rp.get());
+                m_ringPipeline->create();
+            }
+        }
+
+        if (m_simulationEnabled) {
+            if (m_instanceCount > 0 || m_objectsBenchmark)
+                qWarning("The simulation is not used with instancing or the objects benchmark");
+            else
+                createSimulation();
+        }
+    }
+
+    // the latching modes are only implemented for the single rotation that
+    // the triangle, the mesh, and static instances share
+    if (m_timeBasedRotation && (m_simulation || m_objectCount > 0 || m_objectsBenchmark || m_instanceAnimation != NoAnimation)) {
+        qWarning("--late-latch and --early-latch are not supported with objects, animated instances, or the simulation, ignoring");
+        m_timeBasedRotation = false;
+        m_lateLatch = false;
+    }
+
+    if (m_swapChainFlags || m_waitForGpu || m_timeBasedRotation) {
+        qDebug("Frames in flight: %d%s, swapchain flags: 0x%x, latching: %s",
+               m_rhi->resourceLimit(QRhi::FramesInFlight), m_waitForGpu ? " (waiting for the GPU after each frame)" : "",
+               int(m_swapChainFlags), m_lateLatch ? "late" : "early");
     }
 
     setTitle(m_rhi->backendName());
 }
 
+bool HelloWindow::createMesh(QRhiShaderResourceBindings *srb, const QShader &vs, const QShader &fs)
+{
+    m_meshLoadTimer.start();
+
+    // With Map, the file contents are not read here, only as the upload
+    // copies them into QRhi's own storage, page by page, and the mapping is
+    // gone right after. QRhi owns the only full copy from then on (until it
+    // is uploaded to the GPU with the first frame), unlike with ReadAll, where
+    // the data exists twice for a while. With streaming, the mapping stays
+    // until everything is uploaded, and QRhi only holds a chunk per frame.
+    m_meshFile.reset(new MeshFile);
+    const MeshFile &mesh(*m_meshFile);
+    QString errorString;
+    if (!m_meshFile->open(m_meshFileName, m_meshOpenMode, &errorString)) {
+        qWarning("Failed to load %s: %s", qPrintable(m_meshFileName), qPrintable(errorString));
+        m_meshFile.reset();
+        return false;
+    }
+
+    const MeshFileHeader &header(mesh.header());
+    const bool index32 = header.indexFormat == MeshFileHeader::UInt32;
+    if (index32 && !m_rhi->isFeatureSupported(QRhi::ElementIndexUint)) {
+        qWarning("32-bit indices are not supported, generate the mesh with --index16");
+        m_meshFile.reset();
+        return false;
+    }
+    // QRhiBuffer sizes, and the index count for drawIndexed(), are 32-bit
+    if (mesh.vertexDataSize() > 0xFFFFFFFFull || mesh.indexDataSize() > 0xFFFFFFFFull) {
+        qWarning("The mesh is too large");
+        m_meshFile.reset();
+        return false;
+    }
+
+    m_meshVbuf.reset(m_rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, quint32(mesh.vertexDataSize())));
+    m_meshIbuf.reset(m_rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::IndexBuffer, quint32(mesh.indexDataSize())));
+    if (!m_meshVbuf->create() || !m_meshIbuf->create()) {
+        qWarning("Failed to create buffers for the mesh");
+        m_meshVbuf.reset();
+        m_meshIbuf.reset();
+        m_meshFile.reset();
+        return false;
+    }
+    m_meshIndexFormat = index32 ? QRhiCommandBuffer::IndexUInt32 : QRhiCommandBuffer::IndexUInt16;
+    m_meshIndexCount = quint32(header.indexCount);
+    if (m_meshStreamingBudget) {
+        // Still Immutable, each region is written exactly once. Whatever has
+        // not been uploaded yet is not drawn, see render().
+        m_meshStreamer.start(m_meshFile.get(), m_meshVbuf.get(), m_meshIbuf.get(), m_meshStreamingBudget);
+    } else {
+        m_initialUpdates->uploadStaticBuffer(m_meshVbuf.get(), mesh.vertexData());
+        m_initialUpdates->uploadStaticBuffer(m_meshIbuf.get(), mesh.indexData());
+    }
+
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { header.vertexStride }
+    });
+    QVarLengthArray<QRhiVertexInputAttribute, MeshFileHeader::MAX_ATTRIBUTES> attributes;
+    for (quint32 i = 0; i < header.attributeCount; ++i) {
+        static const QRhiVertexInputAttribute::Format formats[] = {
+            QRhiVertexInputAttribute::Float,
+            QRhiVertexInputAttribute::Float2,
+            QRhiVertexInputAttribute::Float3,
+            QRhiVertexInputAttribute::Float4
+        };
+        const MeshFileHeader::Attribute &a(header.attributes[i]);
+        attributes.append({ 0, int(a.location), formats[a.components - 1], a.offset });
+    }
+    inputLayout.setAttributes(attributes.cbegin(), attributes.cend());
+
+    // same shaders as the triangle, the vec4 position gets w = 1 from the
+    // vec3 input
+    m_meshPipeline.reset(m_rhi->newGraphicsPipeline());
+    m_meshPipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, vs },
+        { QRhiShaderStage::Fragment, fs }
+    });
+    m_meshPipeline->setDepthTest(true);
+    m_meshPipeline->setDepthWrite(true);
+    m_meshPipeline->setCullMode(QRhiGraphicsPipeline::Back);
+    m_meshPipeline->setVertexInputLayout(inputLayout);
+    m_meshPipeline->setShaderResourceBindings(srb);
+    m_meshPipeline->setRenderPassDescriptor(m_rp.get());
+    m_meshPipeline->create();
+
+    m_meshLoadTime = m_meshLoadTimer.nsecsElapsed();
+    m_reportMesh = true;
+    qDebug("Mesh %s: %u triangles, %llu vertices, %d-bit indices",
+           qPrintable(m_meshFileName), m_meshIndexCount / 3, header.vertexCount, index32 ? 32 : 16);
+
+    // with everything enqueued, QRhi has its own copy of the data
+    if (!m_meshStreamer.isActive())
+        m_meshFile.reset();
+
+    return true;
+}
+
+void HelloWindow::streamMesh(QRhiResourceUpdateBatch *resourceUpdates)
+{
+    // the cost on the CPU side, i.e. QRhi copying the chunks, the GPU side is
+    // part of the GPU time in the frame timings
+    QElapsedTimer timer;
+    timer.start();
+    m_meshStreamer.uploadNext(resourceUpdates);
+    const qint64 t = timer.nsecsElapsed();
+    ++m_meshStreamingFrames;
+    m_meshStreamingTime += t;
+    m_meshStreamingMaxTime = qMax(m_meshStreamingMaxTime, t);
+
+    if (!m_meshStreamer.isActive()) {
+        m_meshFile.reset();
+        if (m_meshStreamer.hasFailed()) {
+            qWarning("Mesh streaming failed after %d frames, %.1f MB", m_meshStreamingFrames,
+                     m_meshStreamer.uploadedBytes() / (1024.0 * 1024.0));
+            if (m_meshBenchmark)
+                QCoreApplication::exit(1);
+            return;
+        }
+        qDebug("Mesh streamed in %d frames, %.2f ms after starting to load: %.1f MB, upload cost per frame: average %.3f ms, max %.3f ms, "
+               "RSS %.1f MB, peak RSS %.1f MB",
+               m_meshStreamingFrames, m_meshLoadTimer.nsecsElapsed() / 1000000.0,
+               m_meshStreamer.uploadedBytes() / (1024.0 * 1024.0),
+               m_meshStreamingTime / 1000000.0 / m_meshStreamingFrames, m_meshStreamingMaxTime / 1000000.0,
+               currentResidentSetSize() / (1024.0 * 1024.0), peakResidentSetSize() / (1024.0 * 1024.0));
+        if (m_meshBenchmark)
+            QCoreApplication::quit();
+    }
+}
+
+void HelloWindow::loadPipelineCache()
+{
+    QFile f(pipelineCacheFileName(m_rhi.get()));
+    if (!f.open(QIODevice::ReadOnly))
+        return;
+
+    const QByteArray contents = f.readAll();
+    quint32 header[2];
+    if (contents.size() <= qsizetype(sizeof(header)))
+        return;
+    memcpy(header, contents.constData(), sizeof(header));
+    if (header[0] != PIPELINE_CACHE_MAGIC || header[1] != PIPELINE_CACHE_VERSION)
+        return;
+
+    m_rhi->setPipelineCacheData(contents.mid(sizeof(header)));
+    m_pipelineCacheLoaded = true;
+}
+
+void HelloWindow::savePipelineCache()
+{
+    if (!m_rhi)
+        return;
+
+    const QByteArray data = m_rhi->pipelineCacheData();
+    if (data.isEmpty())
+        return;
+
+    const QString fileName = pipelineCacheFileName(m_rhi.get());
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Failed to write pipeline cache to %s", qPrintable(fileName));
+        return;
+    }
+    const quint32 header[2] = { PIPELINE_CACHE_MAGIC, PIPELINE_CACHE_VERSION };
+    f.write(reinterpret_cast<const char *>(header), sizeof(header));
+    f.write(data);
+}
+
+void HelloWindow::createInstanceBuffer()
+{
+    // The instances are laid out in a square grid in the XY plane, each with a
+    // different rotation, the whole grid then rotates like the single triangle
+    // does otherwise.
+    const int columns = qCeil(qSqrt(m_instanceCount));
+    const float cellSize = 3.0f / columns;
+    QByteArray data(qsizetype(m_instanceCount) * 4 * sizeof(float), Qt::Uninitialized);
+    float *p = reinterpret_cast<float *>(data.data());
+    for (int i = 0; i < m_instanceCount; ++i) {
+        *p++ = -1.5f + (i % columns + 0.5f) * cellSize;
+        *p++ = -1.5f + (i / columns + 0.5f) * cellSize;
+        *p++ = cellSize * 0.9f;
+        *p++ = i * 2.399963f; // golden angle, to make neighbors differ
+    }
+
+    QRhiBuffer::Type type = QRhiBuffer::Immutable;
+    QRhiBuffer::UsageFlags usage = QRhiBuffer::VertexBuffer;
+    m_instanceData.clear();
+    if (m_instanceAnimation == CpuAnimation) {
+        // the whole buffer is rewritten in every frame
+        type = QRhiBuffer::Dynamic;
+        m_instanceData = data;
+    } else if (m_instanceAnimation == GpuAnimation) {
+        // written by the compute shader, read as vertex input
+        usage |= QRhiBuffer::StorageBuffer;
+    }
+
+    // the old buffer, if any, may still be in use by frames in flight, QRhi
+    // defers the actual release as appropriate
+    m_instanceBuf.reset(m_rhi->newBuffer(type, usage, data.size()));
+    if (!m_instanceBuf->create())
+        qFatal("Failed to create instance buffer for %d instances", m_instanceCount);
+
+    if (m_instanceAnimation == GpuAnimation) {
+        m_computeSrb.reset(m_rhi->newShaderResourceBindings());
+        m_computeSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::ComputeStage, m_animationUbuf.get()),
+            QRhiShaderResourceBinding::bufferLoadStore(1, QRhiShaderResourceBinding::ComputeStage, m_instanceBuf.get())
+        });
+        m_computeSrb->create();
+
+        if (!m_computePipeline) {
+            m_computePipeline.reset(m_rhi->newComputePipeline());
+            QFile f(QLatin1String(":/shaders/animate.comp.qsb"));
+            if (f.open(QIODevice::ReadOnly))
+                m_computePipeline->setShaderStage({ QRhiShaderStage::Compute, QShader::fromSerialized(f.readAll()) });
+            m_computePipeline->setShaderResourceBindings(m_computeSrb.get());
+            m_computePipeline->create();
+        }
+    }
+
+    if (type == QRhiBuffer::Dynamic)
+        return;
+
+    if (!m_initialUpdates)
+        m_initialUpdates = m_rhi->nextResourceUpdateBatch();
+    m_initialUpdates->uploadStaticBuffer(m_instanceBuf.get(), data.constData());
+}
+
+void HelloWindow::createComputeAnimation()
+{
+    // The uniform buffer is shared by the compute and the vertex shader. The
+    // view-projection matrix is uploaded only when it changes, so per frame
+    // the CPU writes only the time, the time delta, and the instance count.
+    m_animationUbuf.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 80));
+    m_animationUbuf->create();
+
+    m_animationSrb.reset(m_rhi->newShaderResourceBindings());
+    m_animationSrb->setBindings({
+        QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, m_animationUbuf.get())
+    });
+    m_animationSrb->create();
+
+    static auto getShader = [](const QString &name) {
+        QFile f(name);
+        return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+    };
+
+    m_animatedPipeline.reset(m_rhi->newGraphicsPipeline());
+    m_animatedPipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color_animated.vert.qsb")) },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
+    });
+    m_animatedPipeline->setVertexInputLayout(m_instancedPipeline->vertexInputLayout());
+    m_animatedPipeline->setShaderResourceBindings(m_animationSrb.get());
+    m_animatedPipeline->setRenderPassDescriptor(m_rp.get());
+    m_animatedPipeline->create();
+
+    // the compute pipeline needs an srb with the instance buffer, so that is
+    // created in createInstanceBuffer()
+}
+
+void HelloWindow::setAnimating(bool animating)
+{
+    if (m_animating == animating)
+        return;
+
+    m_animating = animating;
+    m_onDemandTimer.invalidate();
+    if (m_initialized)
+        requestUpdate();
+}
+
+bool HelloWindow::isAnimating() const
+{
+    // the other modes are there to stress things, those always animate, and
+    // a streamed mesh needs frames until it is all uploaded
+    return m_animating || m_objectCount > 0 || m_simulation || m_instanceAnimation != NoAnimation
+        || m_meshStreamer.isActive();
+}
+
+void HelloWindow::keyPressEvent(QKeyEvent *e)
+{
+    if (e->key() == Qt::Key_Space)
+        setAnimating(!m_animating);
+    else
+        QWindow::keyPressEvent(e);
+}
+
+void HelloWindow::sampleRotation()
+{
+    // 60 degrees per second, with the time taken right here; how late in the
+    // frame this happens determines how old the state is when presented
+    m_sampleTime = QDeadlineTimer::current().deadlineNSecs();
+    m_rotation = std::fmod(m_sampleTime / 1000000000.0 * 60.0, 360.0);
+}
+
+void HelloWindow::createSimulation()
+{
+    if (m_objectCount > 0) {
+        const int stride = m_objectUniforms == RingUniforms ? m_uniformRing.stride() : 64;
+        m_simulation.reset(new Simulation(m_objects, stride, 0.02f));
+    } else {
+        // the single triangle, 1 degree per frame, like without the simulation
+        ObjectTransforms triangle;
+        triangle.resize(1);
+        m_simulation.reset(new Simulation(triangle, 64, qDegreesToRadians(1.0f)));
+    }
+    m_simulation->setCost(m_simulationCost);
+}
+
+void HelloWindow::uploadSimulationState(QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (m_simulationThreaded) {
+        // the worker starts once the view-projection matrix is known
+        if (!m_simulation->isThreaded())
+            m_simulation->start();
+    } else {
+        m_simulation->step();
+    }
+
+    // With the worker thread this is the state calculated while the previous
+    // frame was being recorded (or an older one, if the simulation is slower
+    // than the rendering), never a partially written one.
+    m_simulation->update();
+    const QByteArray &matrices = m_simulation->state().matrices;
+    m_sampleTime = m_simulation->state().sampleTime;
+
+    if (m_objectCount == 0) {
+        resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, matrices.constData());
+    } else if (m_objectUniforms == RingUniforms) {
+        m_uniformRing.reset();
+        const qint64 offset = m_uniformRing.allocate(m_objectCount);
+        memcpy(m_uniformRing.data(offset), matrices.constData(), matrices.size());
+        m_uniformRing.commit(resourceUpdates);
+    } else {
+        for (int i = 0; i < m_objectCount; ++i)
+            resourceUpdates->updateDynamicBuffer(m_objectResources[i].ubuf.get(), 0, 64, matrices.constData() + i * 64);
+    }
+
+    // the next state is calculated while this frame is recorded and submitted
+    if (m_simulationThreaded)
+        m_simulation->requestStep();
+}
+
+void HelloWindow::createObjects()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // a square grid, like with instancing
+    const int columns = qCeil(qSqrt(m_objectCount));
+    const float cellSize = 3.0f / columns;
+    m_objects.resize(m_objectCount);
+    m_objects.setScale(cellSize * 0.9f);
+    for (int i = 0; i < m_objectCount; ++i) {
+        m_objects.translationsX()[i] = -1.5f + (i % columns + 0.5f) * cellSize;
+        m_objects.translationsY()[i] = -1.5f + (i / columns + 0.5f) * cellSize;
+        m_objects.translationsZ()[i] = 0.0f;
+        m_objects.rotations()[i] = i * 2.399963f;
+    }
+
+    // the old resources, if any, may still be in use by frames in flight, QRhi
+    // defers the actual release as appropriate
+    m_objectResources.clear();
+    if (m_objectUniforms == RingUniforms) {
+        if (!m_uniformRing.create(m_rhi.get(), 64, m_objectCount))
+            qFatal("Failed to create uniform buffer for %d objects", m_objectCount);
+        m_ringSrb.reset(m_rhi->newShaderResourceBindings());
+        m_ringSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBufferWithDynamicOffset(0, QRhiShaderResourceBinding::VertexStage, m_uniformRing.buffer(), 64)
+        });
+        m_ringSrb->create();
+    } else {
+        m_objectResources.resize(m_objectCount);
+        for (ObjectResources &r : m_objectResources) {
+            r.ubuf.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64));
+            r.ubuf->create();
+            r.srb.reset(m_rhi->newShaderResourceBindings());
+            r.srb->setBindings({
+                QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, r.ubuf.get())
+            });
+            r.srb->create();
+        }
+        m_objectMvps.resize(qsizetype(m_objectCount) * 64);
+    }
+
+    m_objectsSetupTime = timer.nsecsElapsed();
+}
+
+void HelloWindow::advanceObjectsBenchmark()
+{
+    static const int SETTLE_FRAMES = 10;
+    if (++m_objectsBenchmarkFrame < SETTLE_FRAMES + FrameTimings::windowSize())
+        return;
+
+    printf("%s, %d objects (setup %.2f ms): %s\n",
+           m_objectUniforms == RingUniforms ? "uniform ring" : "separate buffers",
+           m_objectCount, m_objectsSetupTime / 1000000.0, qPrintable(m_timings.summaryText()));
+    fflush(stdout);
+
+    m_objectsBenchmarkFrame = 0;
+    if (m_objectCount < OBJECTS_BENCHMARK_MAX) {
+        m_objectCount *= 10;
+    } else if (m_objectUniforms == RingUniforms) {
+        m_objectUniforms = SeparateUniforms;
+        m_objectCount = OBJECTS_BENCHMARK_START;
+    } else {
+        QCoreApplication::quit();
+        return;
+    }
+    createObjects();
+}
+
+void HelloWindow::advanceInstanceSweep()
+{
+    // Measures each step for exactly as many frames as the statistics window
+    // covers (plus a few to get rid of the hiccup caused by the upload), then
+    // goes up by a factor of 10, from 1 to 10 million instances.
+
+    static const int SETTLE_FRAMES = 10;
+    if (++m_instanceSweepFrame < SETTLE_FRAMES + FrameTimings::windowSize())
+        return;
+
+    static const char *animationNames[] = { "", "CPU animation, ", "GPU animation, " };
+    printf("%s%d instances: %s\n", animationNames[m_instanceAnimation], m_instanceCount, qPrintable(m_timings.summaryText()));
+    fflush(stdout);
+
+    if (m_instanceCount >= m_instanceSweepMax) {
+        if (m_animationBenchmark && m_instanceAnimation == CpuAnimation && m_animatedPipeline) {
+            // same again, with the compute shader
+            m_instanceAnimation = GpuAnimation;
+            m_instanceCount = ANIMATION_BENCHMARK_START;
+            m_instanceSweepFrame = 0;
+            createInstanceBuffer();
+            return;
+        }
+        QCoreApplication::quit();
+        return;
+    }
+
+    m_instanceCount *= 10;
+    m_instanceSweepFrame = 0;
+    createInstanceBuffer();
+}
+
 void HelloWindow::resizeSwapChain()
 {
     m_hasSwapChain = m_sc->createOrResize();
@@ -227,6 +988,9 @@ void HelloWindow::resizeSwapChain()
     m_viewProjection = m_rhi->clipSpaceCorrMatrix();
     m_viewProjection.perspective(45.0f, outputSize.width() / (float) outputSize.height(), 0.01f, 1000.0f);
     m_viewProjection.translate(0, 0, -4);
+    m_viewProjectionChanged = true;
+    if (m_simulation)
+        m_simulation->setViewProjection(m_viewProjection);
 }
 
 void HelloWindow::releaseSwapChain()
@@ -249,6 +1013,16 @@ void HelloWindow::render()
         m_newlyExposed = false;
     }
 
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    const qint64 frameInterval = m_frameIntervalTimer.isValid() ? m_frameIntervalTimer.nsecsElapsed() : 0;
+    m_frameIntervalTimer.start();
+
+    // Early latching: the state is sampled before beginFrame(), which may
+    // block for a long time, so the presented frame shows an older state.
+    if (m_timeBasedRotation && !m_lateLatch)
+        sampleRotation();
+
     QRhi::FrameOpResult result = m_rhi->beginFrame(m_sc.get());
     if (result == QRhi::FrameOpSwapChainOutOfDate) {
         resizeSwapChain();
@@ -262,6 +1036,15 @@ void HelloWindow::render()
         return;
     }
 
+    // beginFrame() blocks when the CPU is too far ahead of the GPU (or of the
+    // presentation engine), so waiting here a lot means GPU (or vsync) bound
+    const qint64 beginFrameEnd = frameTimer.nsecsElapsed();
+
+    ++m_framesRendered;
+    if (m_dirty || isAnimating())
+        ++m_framesNeeded;
+    m_dirty = false;
+
     // the actual rendering
     {
         QRhiCommandBuffer *cb = m_sc->currentFrameCommandBuffer();
@@ -274,31 +1057,207 @@ void HelloWindow::render()
             m_initialUpdates = nullptr;
         }
 
-        m_rotation += 1.0f;
-        QMatrix4x4 modelViewProjection = m_viewProjection;
-        modelViewProjection.rotate(m_rotation, 0, 1, 0);
-        resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, modelViewProjection.constData());
+        if (m_meshStreamer.isActive())
+            streamMesh(resourceUpdates);
+
+        if (m_simulation) {
+            uploadSimulationState(resourceUpdates);
+        } else if (m_objectCount > 0) {
+            m_sampleTime = QDeadlineTimer::current().deadlineNSecs();
+            float *rotations = m_objects.rotations();
+            for (int i = 0; i < m_objectCount; ++i)
+                rotations[i] = std::fmod(rotations[i] + 0.02f, 6.2831853f);
+            if (m_objectUniforms == RingUniforms) {
+                // everything goes up with a single updateDynamicBuffer()
+                m_uniformRing.reset();
+                const qint64 offset = m_uniformRing.allocate(m_objectCount);
+                m_objects.calculateMvps(m_viewProjection, m_uniformRing.data(offset), m_uniformRing.stride());
+                m_uniformRing.commit(resourceUpdates);
+            } else {
+                m_objects.calculateMvps(m_viewProjection, m_objectMvps.data(), 64);
+                for (int i = 0; i < m_objectCount; ++i)
+                    resourceUpdates->updateDynamicBuffer(m_objectResources[i].ubuf.get(), 0, 64, m_objectMvps.constData() + i * 64);
+            }
+        } else if (m_instanceAnimation == NoAnimation) {
+            if (!m_timeBasedRotation) {
+                if (m_onDemand) {
+                    // 60 degrees per second, regardless of how often frames are rendered
+                    if (m_animating && m_onDemandTimer.isValid())
+                        m_rotation += m_onDemandTimer.nsecsElapsed() / 1000000000.0f * 60.0f;
+                    if (m_animating)
+                        m_onDemandTimer.start();
+                } else if (m_animating) {
+                    m_rotation += 1.0f;
+                }
+                m_sampleTime = QDeadlineTimer::current().deadlineNSecs();
+            } else if (m_lateLatch) {
+                // late latching: right before the upload
+                sampleRotation();
+            }
+            QMatrix4x4 modelViewProjection = m_viewProjection;
+            modelViewProjection.rotate(m_rotation, 0, 1, 0);
+            resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, modelViewProjection.constData());
+        } else {
+            // time based, to get the same animation with both CPU and GPU
+            float dt = 0.0f;
+            if (m_animationTimer.isValid())
+                dt = qMin(0.1f, m_animationTimer.nsecsElapsed() / 1000000000.0f);
+            m_animationTimer.start();
+            m_animationTime += dt;
+            m_sampleTime = QDeadlineTimer::current().deadlineNSecs();
+
+            if (m_instanceAnimation == CpuAnimation) {
+                QMatrix4x4 modelViewProjection = m_viewProjection;
+                modelViewProjection.rotate(m_animationTime * 60.0f, 0, 1, 0);
+                resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, modelViewProjection.constData());
+
+                float *p = reinterpret_cast<float *>(m_instanceData.data());
+                for (int i = 0; i < m_instanceCount; ++i, p += 4)
+                    p[3] = std::fmod(p[3] + instanceSpeed(i) * dt, 6.2831853f);
+                resourceUpdates->updateDynamicBuffer(m_instanceBuf.get(), 0, m_instanceData.size(), m_instanceData.constData());
+            } else {
+                if (m_viewProjectionChanged) {
+                    m_viewProjectionChanged = false;
+                    resourceUpdates->updateDynamicBuffer(m_animationUbuf.get(), 0, 64, m_viewProjection.constData());
+                }
+                const float params[2] = { m_animationTime, dt };
+                const quint32 count = m_instanceCount;
+                resourceUpdates->updateDynamicBuffer(m_animationUbuf.get(), 64, 8, params);
+                resourceUpdates->updateDynamicBuffer(m_animationUbuf.get(), 72, 4, &count);
+
+                cb->beginComputePass(resourceUpdates);
+                cb->setComputePipeline(m_computePipeline.get());
+                cb->setShaderResources(m_computeSrb.get());
+                cb->dispatch((m_instanceCount + 255) / 256, 1, 1);
+                cb->endComputePass();
+                resourceUpdates = nullptr;
+            }
+        }
 
         const QColor clearColor = QColor::fromRgbF(0.4f, 0.7f, 0.0f, 1.0f);
         cb->beginPass(m_sc->currentFrameRenderTarget(), clearColor, { 1.0f, 0 }, resourceUpdates);
 
-        cb->setGraphicsPipeline(m_pipeline.get());
-        cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
-        cb->setShaderResources();
-        const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf.get(), 0);
-        cb->setVertexInput(0, 1, &vbufBinding);
-        cb->draw(3);
+        if (m_instanceCount > 0) {
+            if (m_instanceAnimation == GpuAnimation)
+                cb->setGraphicsPipeline(m_animatedPipeline.get());
+            else
+                cb->setGraphicsPipeline(m_instancedPipeline.get());
+            cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+            cb->setShaderResources();
+            const QRhiCommandBuffer::VertexInput vbufBindings[] = {
+                { m_vbuf.get(), 0 },
+                { m_instanceBuf.get(), 0 }
+            };
+            cb->setVertexInput(0, 2, vbufBindings);
+            cb->draw(3, m_instanceCount);
+        } else if (m_objectCount > 0) {
+            const bool ring = m_objectUniforms == RingUniforms;
+            cb->setGraphicsPipeline(ring ? m_ringPipeline.get() : m_pipeline.get());
+            cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+            const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf.get(), 0);
+            cb->setVertexInput(0, 1, &vbufBinding);
+            for (int i = 0; i < m_objectCount; ++i) {
+                if (ring) {
+                    // the objects' blocks were allocated in one go, starting at 0
+                    const QRhiCommandBuffer::DynamicOffset dynamicOffset(0, quint32(i) * m_uniformRing.stride());
+                    cb->setShaderResources(m_ringSrb.get(), 1, &dynamicOffset);
+                } else {
+                    cb->setShaderResources(m_objectResources[i].srb.get());
+                }
+                cb->draw(3);
+            }
+        } else if (m_meshPipeline) {
+            cb->setGraphicsPipeline(m_meshPipeline.get());
+            cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+            cb->setShaderResources();
+            const QRhiCommandBuffer::VertexInput vbufBinding(m_meshVbuf.get(), 0);
+            cb->setVertexInput(0, 1, &vbufBinding, m_meshIbuf.get(), 0, m_meshIndexFormat);
+            const quint32 indexCount = m_meshStreamingBudget ? m_meshStreamer.drawableIndexCount() : m_meshIndexCount;
+            if (indexCount)
+                cb->drawIndexed(indexCount);
+        } else {
+            cb->setGraphicsPipeline(m_pipeline.get());
+            cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+            cb->setShaderResources();
+            const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf.get(), 0);
+            cb->setVertexInput(0, 1, &vbufBinding);
+            cb->draw(3);
+        }
 
         cb->endPass();
     }
 
+    const qint64 recordEnd = frameTimer.nsecsElapsed();
+    // this is for a frame that completed earlier, with 0 meaning not (yet) available
+    const double gpuTime = m_sc->currentFrameCommandBuffer()->lastCompletedGpuTime();
+
     m_rhi->endFrame(m_sc.get());
 
-    requestUpdate();
+    // before the wait below, that is not part of this frame's latency but
+    // shows up in the next frame's interval
+    const qint64 latency = m_sampleTime ? QDeadlineTimer::current().deadlineNSecs() - m_sampleTime : 0;
+
+    // Emulates a single frame in flight: the next frame starts only when the
+    // GPU is done with this one, so it samples the state as late as possible
+    // relative to what is on screen, at the cost of CPU/GPU overlap.
+    if (m_waitForGpu)
+        m_rhi->finish();
+
+    // only when something is going to look at the timings
+    if (m_timingReport || m_timings.isHistoryEnabled() || m_instanceSweep || m_objectsBenchmark) {
+        m_timings.addSample({ frameInterval / 1000000.0f,
+                              beginFrameEnd / 1000000.0f,
+                              (recordEnd - beginFrameEnd) / 1000000.0f,
+                              float(gpuTime * 1000.0),
+                              latency / 1000000.0f });
+    }
+    if (m_timingReport) {
+        if (!m_timingReportTimer.isValid()) {
+            m_timingReportTimer.start();
+        } else if (m_timingReportTimer.elapsed() >= 1000) {
+            m_timingReportTimer.restart();
+            const QString text = m_timings.summaryText();
+            printf("%s\n", qPrintable(text));
+            fflush(stdout);
+            setTitle(QString::fromLatin1(m_rhi->backendName()) + QLatin1String(" - ") + text);
+        }
+    }
+
+    if (m_instanceSweep)
+        advanceInstanceSweep();
+    if (m_objectsBenchmark)
+        advanceObjectsBenchmark();
+
+    if (m_reportStartup) {
+        m_reportStartup = false;
+        qDebug("Time to first frame: %lld ms (pipeline cache %s)", m_startupTimer.elapsed(),
+               m_pipelineCacheLoaded ? "warm" : "cold");
+    }
+
+    // Without streaming, the first frame is the one uploading the mesh. Peak
+    // RSS is what shows the difference between mapping and reading the file,
+    // and between streaming or not.
+    if (m_reportMesh) {
+        m_reportMesh = false;
+        qDebug("Mesh (%s%s): loaded in %.2f ms, first frame submitted %.2f ms after starting to load, RSS %.1f MB, peak RSS %.1f MB",
+               m_meshOpenMode == MeshFile::Map ? "mapped" : "read all", m_meshStreamingBudget ? ", streaming" : "",
+               m_meshLoadTime / 1000000.0, m_meshLoadTimer.nsecsElapsed() / 1000000.0,
+               currentResidentSetSize() / (1024.0 * 1024.0), peakResidentSetSize() / (1024.0 * 1024.0));
+        if (m_meshBenchmark && !m_meshStreamingBudget) {
+            QCoreApplication::quit();
+            return;
+        }
+    }
+
+    if (!m_onDemand || isAnimating())
+        requestUpdate();
 }
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
     QRhi::Implementation graphicsApi;
@@ -327,6 +1286,52 @@ int main(int argc, char **argv)
     cmdLineParser.addOption(d3d12Option);
     QCommandLineOption mtlOption({ "m", "metal" }, QLatin1String("Metal"));
     cmdLineParser.addOption(mtlOption);
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame, and if the pipeline cache was used"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption timingOption({ "t", "timing" }, QLatin1String("Print frame timing statistics every second, also shown in the window title"));
+    cmdLineParser.addOption(timingOption);
+    QCommandLineOption instancesOption({ "i", "instances" }, QLatin1String("Draw N instances of the triangle with a single instanced draw call"), QLatin1String("N"));
+    cmdLineParser.addOption(instancesOption);
+    QCommandLineOption instanceSweepOption("instance-sweep", QLatin1String("Report frame timings with 1, 10, 100, ... up to 10 million instances, then exit"));
+    cmdLineParser.addOption(instanceSweepOption);
+    QCommandLineOption animationOption("animation", QLatin1String("Animate each instance, on the CPU (cpu) or with a compute shader (gpu)"), QLatin1String("cpu|gpu"));
+    cmdLineParser.addOption(animationOption);
+    QCommandLineOption animationBenchOption("animation-bench", QLatin1String("Report frame timings for 1K to 1M animated instances, first with CPU, then with GPU animation, then exit"));
+    cmdLineParser.addOption(animationBenchOption);
+    QCommandLineOption objectsOption("objects", QLatin1String("Draw N triangles with one draw call each, taking their uniform data from one buffer with dynamic offsets"), QLatin1String("N"));
+    cmdLineParser.addOption(objectsOption);
+    QCommandLineOption separateUniformsOption("separate-uniforms", QLatin1String("With --objects, use one uniform buffer and srb per object instead"));
+    cmdLineParser.addOption(separateUniformsOption);
+    QCommandLineOption objectsBenchOption("objects-bench", QLatin1String("Report frame timings for 100 to 10K objects with a shared and with separate uniform buffers, then exit"));
+    cmdLineParser.addOption(objectsBenchOption);
+    QCommandLineOption simThreadOption("sim-thread", QLatin1String("Calculate the state of the next frame on a worker thread while the current one is rendered"));
+    cmdLineParser.addOption(simThreadOption);
+    QCommandLineOption simCostOption("sim-cost-ms", QLatin1String("Make each simulation step take at least this long (implies using the simulation, on the GUI thread without --sim-thread)"), QLatin1String("ms"));
+    cmdLineParser.addOption(simCostOption);
+    QCommandLineOption noVSyncOption("no-vsync", QLatin1String("Request a swapchain without vsync (QRhiSwapChain::NoVSync)"));
+    cmdLineParser.addOption(noVSyncOption);
+    QCommandLineOption minimalBuffersOption("minimal-buffers", QLatin1String("Request as few swapchain buffers as possible (QRhiSwapChain::MinimalBufferCount)"));
+    cmdLineParser.addOption(minimalBuffersOption);
+    QCommandLineOption framesInFlightOption("frames-in-flight", QLatin1String("1 waits for the GPU to finish each frame before starting the next; otherwise the backend's default is used"), QLatin1String("count"));
+    cmdLineParser.addOption(framesInFlightOption);
+    QCommandLineOption lateLatchOption("late-latch", QLatin1String("Make the rotation time based, and sample it right before the uniform upload, after beginFrame()"));
+    cmdLineParser.addOption(lateLatchOption);
+    QCommandLineOption earlyLatchOption("early-latch", QLatin1String("Make the rotation time based, and sample it before beginFrame()"));
+    cmdLineParser.addOption(earlyLatchOption);
+    QCommandLineOption onDemandOption("on-demand", QLatin1String("Render only when something changed, with a time based animation (toggled with Space)"));
+    cmdLineParser.addOption(onDemandOption);
+    QCommandLineOption noAnimationOption("no-animation", QLatin1String("Start with the animation stopped"));
+    cmdLineParser.addOption(noAnimationOption);
+    QCommandLineOption meshOption("mesh", QLatin1String("Draw an indexed mesh from a file generated by meshgen instead of the triangle"), QLatin1String("file"));
+    cmdLineParser.addOption(meshOption);
+    QCommandLineOption meshReadAllOption("mesh-read-all", QLatin1String("Read the whole mesh file into memory instead of mapping it, for comparison"));
+    cmdLineParser.addOption(meshReadAllOption);
+    QCommandLineOption meshBenchOption("mesh-bench", QLatin1String("With --mesh, report the load time and memory usage after the first frame (or once streamed), then exit"));
+    cmdLineParser.addOption(meshBenchOption);
+    QCommandLineOption streamBudgetOption("stream-budget", QLatin1String("With --mesh, upload at most this many megabytes per frame, drawing the mesh progressively"), QLatin1String("MB"));
+    cmdLineParser.addOption(streamBudgetOption);
+    QCommandLineOption timingCsvOption("timing-csv", QLatin1String("Write the timings of all frames to a CSV file on exit"), QLatin1String("file"));
+    cmdLineParser.addOption(timingCsvOption);
 
     cmdLineParser.process(app);
     if (cmdLineParser.isSet(nullOption))
@@ -363,6 +1368,62 @@ int main(int argc, char **argv)
 #endif
 
     HelloWindow window(graphicsApi);
+    if (cmdLineParser.isSet(reportStartupOption))
+        window.setStartupTimer(startupTimer);
+    window.setTimingReportEnabled(cmdLineParser.isSet(timingOption));
+    window.setTimingHistoryEnabled(cmdLineParser.isSet(timingCsvOption));
+    QRhiSwapChain::Flags swapChainFlags;
+    if (cmdLineParser.isSet(noVSyncOption))
+        swapChainFlags |= QRhiSwapChain::NoVSync;
+    if (cmdLineParser.isSet(minimalBuffersOption))
+        swapChainFlags |= QRhiSwapChain::MinimalBufferCount;
+    window.setSwapChainFlags(swapChainFlags);
+    window.setOnDemandEnabled(cmdLineParser.isSet(onDemandOption));
+    if (cmdLineParser.isSet(noAnimationOption))
+        window.setAnimating(false);
+    if (cmdLineParser.isSet(framesInFlightOption)) {
+        // QRhi offers no way to change the number of frames in flight, only
+        // to query it, so 1 is emulated by waiting after each frame
+        const int framesInFlight = cmdLineParser.value(framesInFlightOption).toInt();
+        if (framesInFlight == 1)
+            window.setWaitForGpuEnabled(true);
+        else
+            qWarning("Only --frames-in-flight 1 is supported, using the backend's default");
+    }
+    if (cmdLineParser.isSet(lateLatchOption) || cmdLineParser.isSet(earlyLatchOption))
+        window.setLatchMode(true, cmdLineParser.isSet(lateLatchOption));
+    if (cmdLineParser.isSet(meshOption)) {
+        window.setMeshFile(cmdLineParser.value(meshOption), cmdLineParser.isSet(meshReadAllOption) ? MeshFile::ReadAll : MeshFile::Map);
+        window.setMeshBenchmarkEnabled(cmdLineParser.isSet(meshBenchOption));
+        if (cmdLineParser.isSet(streamBudgetOption))
+            window.setMeshStreamingBudget(quint64(qMax(0.001, cmdLineParser.value(streamBudgetOption).toDouble()) * 1024 * 1024));
+    }
+    if (cmdLineParser.isSet(simThreadOption) || cmdLineParser.isSet(simCostOption))
+        window.setSimulationEnabled(cmdLineParser.isSet(simThreadOption), cmdLineParser.value(simCostOption).toInt());
+    if (cmdLineParser.isSet(objectsBenchOption)) {
+        window.setObjectsBenchmarkEnabled(true);
+    } else if (cmdLineParser.isSet(objectsOption)) {
+        window.setObjectCount(qMax(1, cmdLineParser.value(objectsOption).toInt()),
+                              cmdLineParser.isSet(separateUniformsOption) ? HelloWindow::SeparateUniforms : HelloWindow::RingUniforms);
+    } else if (cmdLineParser.isSet(instanceSweepOption)) {
+        window.setInstanceCount(1);
+        window.setInstanceSweepEnabled(true);
+    } else if (cmdLineParser.isSet(instancesOption)) {
+        window.setInstanceCount(qMax(1, cmdLineParser.value(instancesOption).toInt()));
+    }
+    if (cmdLineParser.isSet(animationBenchOption)) {
+        window.setAnimationBenchmarkEnabled(true);
+    } else if (cmdLineParser.isSet(animationOption)) {
+        const QString animation = cmdLineParser.value(animationOption);
+        if (animation == QLatin1String("cpu"))
+            window.setInstanceAnimation(HelloWindow::CpuAnimation);
+        else if (animation == QLatin1String("gpu"))
+            window.setInstanceAnimation(HelloWindow::GpuAnimation);
+        else
+            qWarning("Unknown animation mode %s", qPrintable(animation));
+        if (!cmdLineParser.isSet(instancesOption) && !cmdLineParser.isSet(instanceSweepOption) && !cmdLineParser.isSet(objectsOption))
+            window.setInstanceCount(1);
+    }
 
 #if QT_CONFIG(vulkan)
     if (graphicsApi == QRhi::Vulkan)
@@ -373,6 +1434,17 @@ int main(int argc, char **argv)
 
     int ret = app.exec();
 
+    window.savePipelineCache();
+
+    if (cmdLineParser.isSet(onDemandOption))
+        qDebug("Frames rendered: %llu, needed: %llu", window.framesRendered(), window.framesNeeded());
+
+    if (cmdLineParser.isSet(timingCsvOption)) {
+        const QString fileName = cmdLineParser.value(timingCsvOption);
+        if (!window.frameTimings().saveCsv(fileName))
+            qWarning("Failed to write %s", qPrintable(fileName));
+    }
+
     if (window.handle())
         window.releaseSwapChain();
 
@@ -0,0 +1,58 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "memoryusage.h"
+
+#if defined(Q_OS_WIN)
+#include <qt_windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_DARWIN)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#elif defined(Q_OS_UNIX)
+#include <QFile>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+qint64 currentResidentSetSize()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.WorkingSetSize);
+#elif defined(Q_OS_DARWIN)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+        return qint64(info.resident_size);
+#elif defined(Q_OS_UNIX)
+    // the second field is the resident size, in pages
+    QFile f(QLatin1String("/proc/self/statm"));
+    if (f.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = f.readAll().split(' ');
+        if (fields.count() >= 2)
+            return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return 0;
+}
+
+qint64 peakResidentSetSize()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize);
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#if defined(Q_OS_DARWIN)
+        return qint64(usage.ru_maxrss); // bytes
+#else
+        return qint64(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+    }
+#endif
+    return 0;
+}
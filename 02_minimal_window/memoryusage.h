@@ -0,0 +1,15 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QtGlobal>
+
+// Resident set size of the process in bytes, 0 when not available on the
+// platform. This includes file-backed pages, e.g. the parts of a memory mapped
+// file that have been accessed.
+qint64 currentResidentSetSize();
+qint64 peakResidentSetSize();
+
+#endif
@@ -0,0 +1,73 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "meshfile.h"
+#include <cstring>
+
+bool MeshFile::open(const QString &fileName, OpenMode mode, QString *errorString)
+{
+    close();
+
+    auto fail = [this, errorString](const QString &msg) {
+        if (errorString)
+            *errorString = msg;
+        close();
+        return false;
+    };
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+        return fail(m_file.errorString());
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < qint64(sizeof(MeshFileHeader)))
+        return fail(QLatin1String("File too small"));
+
+    if (mode == Map) {
+        m_data = m_file.map(0, fileSize);
+        if (!m_data)
+            return fail(m_file.errorString());
+    } else {
+        m_contents = m_file.readAll();
+        if (m_contents.size() != fileSize)
+            return fail(m_file.errorString());
+        m_data = reinterpret_cast<const uchar *>(m_contents.constData());
+    }
+
+    memcpy(&m_header, m_data, sizeof(MeshFileHeader));
+    if (m_header.magic != MeshFileHeader::MAGIC)
+        return fail(QLatin1String("Not a mesh file"));
+    if (m_header.version != MeshFileHeader::VERSION)
+        return fail(QString::asprintf("Unsupported version %u", m_header.version));
+    if (m_header.attributeCount < 1 || m_header.attributeCount > quint32(MeshFileHeader::MAX_ATTRIBUTES))
+        return fail(QString::asprintf("Invalid attribute count %u", m_header.attributeCount));
+    for (quint32 i = 0; i < m_header.attributeCount; ++i) {
+        const MeshFileHeader::Attribute &a(m_header.attributes[i]);
+        if (a.components < 1 || a.components > 4 || a.offset + a.components * sizeof(float) > m_header.vertexStride)
+            return fail(QString::asprintf("Invalid attribute %u", i));
+    }
+    if (m_header.indexFormat != MeshFileHeader::UInt16 && m_header.indexFormat != MeshFileHeader::UInt32)
+        return fail(QString::asprintf("Invalid index format %u", m_header.indexFormat));
+
+    // the sizes are checked without overflowing, the counts come from the file
+    const quint64 size = quint64(fileSize);
+    if (m_header.vertexStride == 0 || m_header.vertexCount > size / m_header.vertexStride
+            || m_header.indexCount > size / indexSize()
+            || m_header.vertexDataOffset > size || vertexDataSize() > size - m_header.vertexDataOffset
+            || m_header.indexDataOffset > size || indexDataSize() > size - m_header.indexDataOffset)
+        return fail(QLatin1String("Truncated file"));
+
+    // The index values are not checked against the vertex count, that would
+    // mean reading the whole file up front.
+    return true;
+}
+
+void MeshFile::close()
+{
+    if (m_data && m_contents.isEmpty())
+        m_file.unmap(const_cast<uchar *>(m_data));
+    m_data = nullptr;
+    m_contents.clear();
+    m_contents.squeeze();
+    m_file.close();
+}
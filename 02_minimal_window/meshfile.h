@@ -0,0 +1,79 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <QFile>
+#include <QString>
+
+// Binary mesh file, as written by meshgen. Little endian, a fixed size header
+// followed by the vertex data and then the index data, both starting at an
+// offset aligned to 16 bytes, so that the file can be memory mapped and the
+// data passed on to the graphics API as-is.
+struct MeshFileHeader
+{
+    static const quint32 MAGIC = 0x534d5254; // "TRMS"
+    static const quint32 VERSION = 1;
+    static const int MAX_ATTRIBUTES = 4;
+
+    enum IndexFormat : quint32 {
+        UInt16,
+        UInt32
+    };
+
+    struct Attribute {
+        quint32 location;
+        quint32 components;     // number of floats, 1-4
+        quint32 offset;         // within a vertex
+        quint32 reserved;
+    };
+
+    quint32 magic;
+    quint32 version;
+    quint32 vertexStride;
+    quint32 attributeCount;
+    Attribute attributes[MAX_ATTRIBUTES];
+    quint32 indexFormat;
+    quint32 reserved;
+    quint64 vertexCount;
+    quint64 indexCount;
+    quint64 vertexDataOffset;   // from the start of the file
+    quint64 indexDataOffset;
+    quint64 reserved2;
+};
+
+static_assert(sizeof(MeshFileHeader) == 128, "MeshFileHeader must not have padding");
+
+// Maps a mesh file into memory. No data is read or copied up front, the
+// pages come in as the vertex and index data is accessed. ReadAll is there
+// for comparison, it reads the whole file into memory first.
+class MeshFile
+{
+public:
+    enum OpenMode {
+        Map,
+        ReadAll
+    };
+
+    ~MeshFile() { close(); }
+
+    bool open(const QString &fileName, OpenMode mode = Map, QString *errorString = nullptr);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    const MeshFileHeader &header() const { return m_header; }
+    quint64 indexSize() const { return m_header.indexFormat == MeshFileHeader::UInt16 ? 2 : 4; }
+    quint64 vertexDataSize() const { return m_header.vertexCount * m_header.vertexStride; }
+    quint64 indexDataSize() const { return m_header.indexCount * indexSize(); }
+    const uchar *vertexData() const { return m_data + m_header.vertexDataOffset; }
+    const uchar *indexData() const { return m_data + m_header.indexDataOffset; }
+
+private:
+    QFile m_file;
+    QByteArray m_contents;
+    const uchar *m_data = nullptr;
+    MeshFileHeader m_header;
+};
+
+#endif
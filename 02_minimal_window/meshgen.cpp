@@ -0,0 +1,147 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+// Generates a sphere with the requested number of triangles (roughly), in the
+// format read by MeshFile. The data is written row by row, so this works for
+// meshes much larger than the available memory as well.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtMath>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "meshfile.h"
+#include "memoryusage.h"
+
+static quint64 alignTo16(quint64 v)
+{
+    return (v + 15) & ~quint64(15);
+}
+
+template <typename T>
+static bool writeData(QFile *f, const std::vector<T> &data)
+{
+    const qint64 size = qint64(data.size() * sizeof(T));
+    return f->write(reinterpret_cast<const char *>(data.data()), size) == size;
+}
+
+template <typename Index>
+static bool writeIndices(QFile *f, quint32 rings, quint32 segments)
+{
+    // two CCW (seen from the outside) triangles per quad
+    std::vector<Index> row;
+    row.reserve(segments * 6);
+    for (quint32 r = 0; r < rings; ++r) {
+        row.clear();
+        for (quint32 s = 0; s < segments; ++s) {
+            const Index a = Index(r * (segments + 1) + s);
+            const Index b = Index((r + 1) * (segments + 1) + s);
+            const Index c = Index(b + 1);
+            const Index d = Index(a + 1);
+            row.insert(row.end(), { a, b, c, a, c, d });
+        }
+        if (!writeData(f, row))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    cmdLineParser.setApplicationDescription(QLatin1String("Generates a sphere mesh for minimal_window --mesh"));
+    QCommandLineOption trianglesOption({ "t", "triangles" }, QLatin1String("Approximate number of triangles (default 1000000)"), QLatin1String("N"), QLatin1String("1000000"));
+    cmdLineParser.addOption(trianglesOption);
+    QCommandLineOption index16Option("index16", QLatin1String("Use 16-bit indices (limits the mesh to 65536 vertices)"));
+    cmdLineParser.addOption(index16Option);
+    cmdLineParser.addPositionalArgument(QLatin1String("output"), QLatin1String("Mesh file to write"));
+    cmdLineParser.process(app);
+
+    if (cmdLineParser.positionalArguments().count() != 1)
+        cmdLineParser.showHelp(1);
+
+    // 2 * rings * segments triangles, with twice as many segments as rings
+    const quint64 requestedTriangles = qMax(8ull, cmdLineParser.value(trianglesOption).toULongLong());
+    const quint32 rings = qMax(2u, quint32(std::sqrt(requestedTriangles / 4.0)));
+    const quint32 segments = rings * 2;
+    const quint64 vertexCount = quint64(rings + 1) * (segments + 1);
+    const quint64 indexCount = quint64(rings) * segments * 6;
+
+    const bool index16 = cmdLineParser.isSet(index16Option);
+    if (index16 && vertexCount > 65536) {
+        qWarning("%llu vertices do not fit in 16-bit indices", vertexCount);
+        return 1;
+    }
+    if (!index16 && vertexCount > 0xFFFFFFFFull) {
+        qWarning("%llu vertices do not fit in 32-bit indices", vertexCount);
+        return 1;
+    }
+
+    // position and color, see color.vert
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MeshFileHeader::MAGIC;
+    header.version = MeshFileHeader::VERSION;
+    header.vertexStride = 6 * sizeof(float);
+    header.attributeCount = 2;
+    header.attributes[0] = { 0, 3, 0, 0 };
+    header.attributes[1] = { 1, 3, 3 * sizeof(float), 0 };
+    header.indexFormat = index16 ? MeshFileHeader::UInt16 : MeshFileHeader::UInt32;
+    header.vertexCount = vertexCount;
+    header.indexCount = indexCount;
+    header.vertexDataOffset = alignTo16(sizeof(MeshFileHeader));
+    header.indexDataOffset = alignTo16(header.vertexDataOffset + vertexCount * header.vertexStride);
+
+    const QString fileName = cmdLineParser.positionalArguments().first();
+    QFile f(fileName);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning("Failed to open %s: %s", qPrintable(fileName), qPrintable(f.errorString()));
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    bool ok = f.write(reinterpret_cast<const char *>(&header), sizeof(header)) == qint64(sizeof(header));
+    ok = ok && f.seek(header.vertexDataOffset);
+
+    std::vector<float> row;
+    row.reserve((segments + 1) * 6);
+    for (quint32 r = 0; ok && r <= rings; ++r) {
+        row.clear();
+        const float phi = float(M_PI) * r / rings;
+        for (quint32 s = 0; s <= segments; ++s) {
+            const float theta = 2.0f * float(M_PI) * s / segments;
+            const float x = std::sin(phi) * std::cos(theta);
+            const float y = std::cos(phi);
+            const float z = -std::sin(phi) * std::sin(theta);
+            // the normal as the color
+            row.insert(row.end(), { x, y, z, x * 0.5f + 0.5f, y * 0.5f + 0.5f, z * 0.5f + 0.5f });
+        }
+        ok = writeData(&f, row);
+    }
+
+    ok = ok && f.seek(header.indexDataOffset);
+    if (ok)
+        ok = index16 ? writeIndices<quint16>(&f, rings, segments) : writeIndices<quint32>(&f, rings, segments);
+
+    if (!ok) {
+        qWarning("Failed to write %s: %s", qPrintable(fileName), qPrintable(f.errorString()));
+        return 1;
+    }
+
+    f.close();
+
+    printf("%s: %llu triangles, %llu vertices, %d-bit indices, %.1f MB, written in %lld ms, peak RSS %.1f MB\n",
+           qPrintable(fileName), indexCount / 3, vertexCount, index16 ? 16 : 32,
+           (header.indexDataOffset + indexCount * (index16 ? 2 : 4)) / (1024.0 * 1024.0),
+           timer.elapsed(), peakResidentSetSize() / (1024.0 * 1024.0));
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "meshstreamer.h"
+#include "meshfile.h"
+
+void MeshStreamer::start(const MeshFile *mesh, QRhiBuffer *vbuf, QRhiBuffer *ibuf, quint64 bytesPerFrame)
+{
+    m_mesh = mesh;
+    m_vbuf = vbuf;
+    m_ibuf = ibuf;
+    m_budget = qMax<quint64>(bytesPerFrame, 1);
+    m_vertexBytesDone = 0;
+    m_indexBytesDone = 0;
+    m_chunkStart = 0;
+    m_chunkVertexBytes = 0;
+    m_drawableIndexCount = 0;
+    m_failed = false;
+}
+
+quint64 MeshStreamer::maxIndex(quint64 first, quint64 last) const
+{
+    quint64 result = 0;
+    if (m_mesh->header().indexFormat == MeshFileHeader::UInt16) {
+        const quint16 *p = reinterpret_cast<const quint16 *>(m_mesh->indexData());
+        for (quint64 i = first; i < last; ++i)
+            result = qMax<quint64>(result, p[i]);
+    } else {
+        const quint32 *p = reinterpret_cast<const quint32 *>(m_mesh->indexData());
+        for (quint64 i = first; i < last; ++i)
+            result = qMax<quint64>(result, p[i]);
+    }
+    return result;
+}
+
+quint64 MeshStreamer::uploadNext(QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (!m_mesh)
+        return 0;
+
+    const MeshFileHeader &header(m_mesh->header());
+    const quint64 vertexDataSize = m_mesh->vertexDataSize();
+    const quint64 indexDataSize = m_mesh->indexDataSize();
+    quint64 budget = m_budget;
+
+    // Whatever is enqueued is copied by QRhi right away, so the file's pages
+    // are only touched here, a chunk at a time.
+    auto uploadVertices = [&](quint64 size) {
+        resourceUpdates->uploadStaticBuffer(m_vbuf, quint32(m_vertexBytesDone), quint32(size), m_mesh->vertexData() + m_vertexBytesDone);
+        m_vertexBytesDone += size;
+        budget -= size;
+    };
+
+    while (budget > 0 && m_indexBytesDone < indexDataSize) {
+        const quint64 chunkEnd = qMin(m_chunkStart + INDEX_CHUNK, header.indexCount);
+        if (!m_chunkVertexBytes) {
+            // the data is touched anyway when uploading, so checking the
+            // indices here costs little, and makes drawing safe
+            const quint64 vertexCount = maxIndex(m_chunkStart, chunkEnd) + 1;
+            if (vertexCount > header.vertexCount) {
+                qWarning("Index out of range, drawing only the first %u indices", m_drawableIndexCount);
+                m_mesh = nullptr;
+                m_failed = true;
+                return m_budget - budget;
+            }
+            m_chunkVertexBytes = vertexCount * header.vertexStride;
+        }
+
+        if (m_vertexBytesDone < m_chunkVertexBytes) {
+            uploadVertices(qMin(budget, m_chunkVertexBytes - m_vertexBytesDone));
+        } else {
+            const quint64 chunkEndBytes = chunkEnd * m_mesh->indexSize();
+            const quint64 size = qMin(budget, chunkEndBytes - m_indexBytesDone);
+            resourceUpdates->uploadStaticBuffer(m_ibuf, quint32(m_indexBytesDone), quint32(size), m_mesh->indexData() + m_indexBytesDone);
+            m_indexBytesDone += size;
+            budget -= size;
+            if (m_indexBytesDone == chunkEndBytes) {
+                m_drawableIndexCount = quint32(chunkEnd);
+                m_chunkStart = chunkEnd;
+                m_chunkVertexBytes = 0;
+            }
+        }
+    }
+
+    // vertices not referenced by any index, for completeness
+    if (budget > 0 && m_indexBytesDone == indexDataSize && m_vertexBytesDone < vertexDataSize)
+        uploadVertices(qMin(budget, vertexDataSize - m_vertexBytesDone));
+
+    if (m_indexBytesDone == indexDataSize && m_vertexBytesDone == vertexDataSize)
+        m_mesh = nullptr;
+
+    return m_budget - budget;
+}
@@ -0,0 +1,49 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef MESHSTREAMER_H
+#define MESHSTREAMER_H
+
+#include <rhi/qrhi.h>
+
+class MeshFile;
+
+// Uploads the vertex and index data of a MeshFile over multiple frames, with
+// at most a given number of bytes per frame, instead of all at once before
+// the first frame. The index data goes up in chunks of whole triangles, each
+// preceded by the vertices it refers to, so that the mesh can be drawn
+// progressively: drawableIndexCount() indices are always safe to draw. The
+// MeshFile must stay open until isActive() returns false.
+class MeshStreamer
+{
+public:
+    void start(const MeshFile *mesh, QRhiBuffer *vbuf, QRhiBuffer *ibuf, quint64 bytesPerFrame);
+    bool isActive() const { return m_mesh != nullptr; }
+    // true if streaming stopped early because of an out of range index
+    bool hasFailed() const { return m_failed; }
+
+    // Enqueues the next uploads onto the batch, returns the number of bytes.
+    quint64 uploadNext(QRhiResourceUpdateBatch *resourceUpdates);
+
+    quint32 drawableIndexCount() const { return m_drawableIndexCount; }
+    quint64 uploadedBytes() const { return m_vertexBytesDone + m_indexBytesDone; }
+
+private:
+    quint64 maxIndex(quint64 first, quint64 last) const;
+
+    // indices per chunk, whole triangles
+    static const quint64 INDEX_CHUNK = 3 * 65536;
+
+    const MeshFile *m_mesh = nullptr;
+    QRhiBuffer *m_vbuf = nullptr;
+    QRhiBuffer *m_ibuf = nullptr;
+    quint64 m_budget = 0;
+    quint64 m_vertexBytesDone = 0;
+    quint64 m_indexBytesDone = 0;
+    quint64 m_chunkStart = 0;
+    quint64 m_chunkVertexBytes = 0; // vertex data the current chunk needs, 0 if not known yet
+    quint32 m_drawableIndexCount = 0;
+    bool m_failed = false;
+};
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "simulation.h"
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <cmath>
+
+Simulation::Simulation(const ObjectTransforms &objects, int stride, float rotationStep)
+    : m_objects(objects),
+      m_stride(stride),
+      m_rotationStep(rotationStep)
+{
+    // allocate up front, step() must not cause the buffers to be reallocated
+    for (int i = 0; i < 3; ++i)
+        m_states.buffers()[i].matrices.resize(qsizetype(objects.count()) * stride);
+}
+
+Simulation::~Simulation()
+{
+    stop();
+}
+
+void Simulation::setViewProjection(const QMatrix4x4 &viewProjection)
+{
+    m_viewProjections.writeBuffer() = viewProjection;
+    m_viewProjections.publish();
+}
+
+void Simulation::start()
+{
+    if (m_thread)
+        return;
+
+    // so that there is something to render in the first frame already
+    step();
+
+    m_quit.storeRelaxed(0);
+    m_thread.reset(QThread::create([this] {
+        for (;;) {
+            m_requests.acquire();
+            if (m_quit.loadAcquire())
+                break;
+            step();
+        }
+    }));
+    m_thread->start();
+}
+
+void Simulation::stop()
+{
+    if (!m_thread)
+        return;
+
+    m_quit.storeRelease(1);
+    m_requests.release();
+    m_thread->wait();
+    m_thread.reset();
+}
+
+void Simulation::requestStep()
+{
+    // no point in queuing up more than one request when the simulation is
+    // slower than the rendering
+    if (m_requests.available() == 0)
+        m_requests.release();
+}
+
+void Simulation::step()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (m_viewProjections.update())
+        m_viewProjection = m_viewProjections.readBuffer();
+
+    float *rotations = m_objects.rotations();
+    for (int i = 0; i < m_objects.count(); ++i)
+        rotations[i] = std::fmod(rotations[i] + m_rotationStep, 6.2831853f);
+
+    State &state = m_states.writeBuffer();
+    state.frame = ++m_frame;
+    state.sampleTime = QDeadlineTimer::current().deadlineNSecs();
+    m_objects.calculateMvps(m_viewProjection, state.matrices.data(), m_stride);
+
+    if (m_costMs > 0) {
+        while (timer.elapsed() < m_costMs)
+            ;
+    }
+
+    m_states.publish();
+}
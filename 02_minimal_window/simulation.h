@@ -0,0 +1,64 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QMatrix4x4>
+#include <QSemaphore>
+#include <QThread>
+#include "transforms.h"
+#include "triplebuffer.h"
+
+// Advances the rotation of the objects and calculates their matrices, either
+// on the calling thread (step()), or on a worker thread (start()), in which
+// case the state for the next frame is calculated while the current one is
+// being recorded and submitted. The state, the view-projection matrix going
+// in and the matrices coming out, is exchanged via triple buffers, so the
+// render loop never waits for the simulation.
+class Simulation
+{
+public:
+    struct State {
+        quint64 frame = 0;
+        qint64 sampleTime = 0; // QDeadlineTimer::current() when the step started
+        QByteArray matrices; // one mat4 per object, stride bytes apart
+    };
+
+    Simulation(const ObjectTransforms &objects, int stride, float rotationStep);
+    ~Simulation();
+
+    // artificial extra cost of each step, to make it visible in the timings
+    void setCost(int ms) { m_costMs = ms; }
+
+    void setViewProjection(const QMatrix4x4 &viewProjection);
+
+    void start();
+    void stop();
+    bool isThreaded() const { return m_thread != nullptr; }
+
+    // Asks the worker thread to calculate the next state, returns right away.
+    void requestStep();
+
+    // Calculates the next state on the calling thread.
+    void step();
+
+    // Picks up the latest state, returns false if there was nothing new.
+    bool update() { return m_states.update(); }
+    const State &state() const { return m_states.readBuffer(); }
+
+private:
+    ObjectTransforms m_objects;
+    int m_stride;
+    float m_rotationStep;
+    int m_costMs = 0;
+    quint64 m_frame = 0;
+    QMatrix4x4 m_viewProjection;
+    TripleBuffer<QMatrix4x4> m_viewProjections;
+    TripleBuffer<State> m_states;
+    std::unique_ptr<QThread> m_thread;
+    QSemaphore m_requests;
+    QAtomicInt m_quit = 0;
+};
+
+#endif
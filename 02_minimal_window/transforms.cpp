@@ -0,0 +1,299 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "transforms.h"
+#include <private/qsimd_p.h>
+#include <cmath>
+#include <cstring>
+
+void ObjectTransforms::resize(int count)
+{
+    m_count = count;
+    const size_t paddedCount = (size_t(count) + 7) & ~size_t(7);
+    m_rotation.resize(paddedCount, 0.0f);
+    m_x.resize(paddedCount, 0.0f);
+    m_y.resize(paddedCount, 0.0f);
+    m_z.resize(paddedCount, 0.0f);
+}
+
+const char *ObjectTransforms::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case AutoKernel:
+        return "auto";
+    case ScalarKernel:
+        return "scalar";
+    case Sse2Kernel:
+        return "SSE2";
+    case Avx2Kernel:
+        return "AVX2";
+    }
+    return "";
+}
+
+// The matrix for one object is VP * T * Ry * S, which boils down to:
+//   col0 = cos * SVP.col0 - sin * SVP.col2
+//   col1 = SVP.col1
+//   col2 = sin * SVP.col0 + cos * SVP.col2
+//   col3 = x * VP.col0 + y * VP.col1 + z * VP.col2 + VP.col3
+// where SVP is VP with the first three columns multiplied by the scale.
+
+static void calculateMvpsScalar(const float *vp, const float *svp, const float *rotation, const float *tx, const float *ty, const float *tz,
+                                int count, char *dst, int stride)
+{
+    for (int i = 0; i < count; ++i) {
+        const float s = std::sin(rotation[i]);
+        const float c = std::cos(rotation[i]);
+        float m[16];
+        for (int r = 0; r < 4; ++r) {
+            m[r] = c * svp[r] - s * svp[8 + r];
+            m[4 + r] = svp[4 + r];
+            m[8 + r] = s * svp[r] + c * svp[8 + r];
+            m[12 + r] = tx[i] * vp[r] + ty[i] * vp[4 + r] + tz[i] * vp[8 + r] + vp[12 + r];
+        }
+        memcpy(dst + qsizetype(i) * stride, m, sizeof(m));
+    }
+}
+
+#ifdef Q_PROCESSOR_X86
+
+// sin and cos for 4 or 8 floats at once, with the same range reduction and
+// polynomials as the Cephes library's sinf/cosf, accurate to about 1e-7 for
+// angles of reasonable magnitude.
+
+static const float SINCOS_DP1 = -0.78515625f;
+static const float SINCOS_DP2 = -2.4187564849853515625e-4f;
+static const float SINCOS_DP3 = -3.77489497744594108e-8f;
+static const float SINCOS_FOPI = 1.27323954473516f; // 4 / pi
+static const float SINCOS_S0 = -1.9515295891e-4f;
+static const float SINCOS_S1 = 8.3321608736e-3f;
+static const float SINCOS_S2 = -1.6666654611e-1f;
+static const float SINCOS_C0 = 2.443315711809948e-5f;
+static const float SINCOS_C1 = -1.388731625493765e-3f;
+static const float SINCOS_C2 = 4.166664568298827e-2f;
+
+static inline void sincosSse2(__m128 x, __m128 *s, __m128 *c)
+{
+    const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000)));
+    __m128 signSin = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    // j = (int(x * 4 / pi) + 1) & ~1, the octant rounded to even
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(SINCOS_FOPI)));
+    j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    const __m128 y = _mm_cvtepi32_ps(j);
+
+    // which polynomial gives sin and which gives cos in this octant
+    const __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+    signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+    const __m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+
+    // x - y * pi / 4, in three steps for precision
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP1)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP2)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(SINCOS_DP3)));
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_C0), z), _mm_set1_ps(SINCOS_C1));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(SINCOS_C2));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, z), z);
+    pc = _mm_sub_ps(pc, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+    pc = _mm_add_ps(pc, _mm_set1_ps(1.0f));
+
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SINCOS_S0), z), _mm_set1_ps(SINCOS_S1));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(SINCOS_S2));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), x), x);
+
+    *s = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, ps), _mm_andnot_ps(polyMask, pc)), signSin);
+    *c = _mm_xor_ps(_mm_or_ps(_mm_and_ps(polyMask, pc), _mm_andnot_ps(polyMask, ps)), signCos);
+}
+
+template <int K>
+static inline __m128 broadcastLane(__m128 v)
+{
+    return _mm_shuffle_ps(v, v, _MM_SHUFFLE(K, K, K, K));
+}
+
+template <int K>
+static inline void storeMvpSse2(const __m128 vp[4], const __m128 svp[3], __m128 s, __m128 c, __m128 x, __m128 y, __m128 z, char *dst)
+{
+    const __m128 sk = broadcastLane<K>(s);
+    const __m128 ck = broadcastLane<K>(c);
+    float *m = reinterpret_cast<float *>(dst);
+    _mm_storeu_ps(m, _mm_sub_ps(_mm_mul_ps(ck, svp[0]), _mm_mul_ps(sk, svp[2])));
+    _mm_storeu_ps(m + 4, svp[1]);
+    _mm_storeu_ps(m + 8, _mm_add_ps(_mm_mul_ps(sk, svp[0]), _mm_mul_ps(ck, svp[2])));
+    _mm_storeu_ps(m + 12, _mm_add_ps(_mm_add_ps(_mm_mul_ps(broadcastLane<K>(x), vp[0]),
+                                                _mm_mul_ps(broadcastLane<K>(y), vp[1])),
+                                     _mm_add_ps(_mm_mul_ps(broadcastLane<K>(z), vp[2]), vp[3])));
+}
+
+static void calculateMvpsSse2(const float *vpData, const float *svpData, const float *rotation, const float *tx, const float *ty, const float *tz,
+                              int count, char *dst, int stride)
+{
+    const __m128 vp[4] = {
+        _mm_loadu_ps(vpData), _mm_loadu_ps(vpData + 4), _mm_loadu_ps(vpData + 8), _mm_loadu_ps(vpData + 12)
+    };
+    const __m128 svp[3] = {
+        _mm_loadu_ps(svpData), _mm_loadu_ps(svpData + 4), _mm_loadu_ps(svpData + 8)
+    };
+    for (int i = 0; i < count; i += 4) {
+        __m128 s, c;
+        sincosSse2(_mm_loadu_ps(rotation + i), &s, &c);
+        const __m128 x = _mm_loadu_ps(tx + i);
+        const __m128 y = _mm_loadu_ps(ty + i);
+        const __m128 z = _mm_loadu_ps(tz + i);
+        char *d = dst + qsizetype(i) * stride;
+        const int n = qMin(4, count - i);
+        storeMvpSse2<0>(vp, svp, s, c, x, y, z, d);
+        if (n > 1)
+            storeMvpSse2<1>(vp, svp, s, c, x, y, z, d + stride);
+        if (n > 2)
+            storeMvpSse2<2>(vp, svp, s, c, x, y, z, d + 2 * stride);
+        if (n > 3)
+            storeMvpSse2<3>(vp, svp, s, c, x, y, z, d + 3 * stride);
+    }
+}
+
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+
+QT_FUNCTION_TARGET(AVX2)
+static inline void sincosAvx2(__m256 x, __m256 *s, __m256 *c)
+{
+    const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(int(0x80000000)));
+    __m256 signSin = _mm256_and_ps(x, signMask);
+    x = _mm256_andnot_ps(signMask, x);
+
+    __m256i j = _mm256_cvttps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(SINCOS_FOPI)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    const __m256 y = _mm256_cvtepi32_ps(j);
+
+    const __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+    signSin = _mm256_xor_ps(signSin, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+    const __m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+
+    x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP1)));
+    x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP2)));
+    x = _mm256_add_ps(x, _mm256_mul_ps(y, _mm256_set1_ps(SINCOS_DP3)));
+    const __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 pc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_C0), z), _mm256_set1_ps(SINCOS_C1));
+    pc = _mm256_add_ps(_mm256_mul_ps(pc, z), _mm256_set1_ps(SINCOS_C2));
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, z), z);
+    pc = _mm256_sub_ps(pc, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+    pc = _mm256_add_ps(pc, _mm256_set1_ps(1.0f));
+
+    __m256 ps = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SINCOS_S0), z), _mm256_set1_ps(SINCOS_S1));
+    ps = _mm256_add_ps(_mm256_mul_ps(ps, z), _mm256_set1_ps(SINCOS_S2));
+    ps = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(ps, z), x), x);
+
+    *s = _mm256_xor_ps(_mm256_blendv_ps(pc, ps, polyMask), signSin);
+    *c = _mm256_xor_ps(_mm256_blendv_ps(ps, pc, polyMask), signCos);
+}
+
+QT_FUNCTION_TARGET(AVX2)
+static void calculateMvpsAvx2(const float *vpData, const float *svpData, const float *rotation, const float *tx, const float *ty, const float *tz,
+                              int count, char *dst, int stride)
+{
+    // two objects at a time: the low 128 bits are for object k, the high
+    // 128 bits for object k + 1
+    const __m256 vp[4] = {
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(vpData)),
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(vpData + 4)),
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(vpData + 8)),
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(vpData + 12))
+    };
+    const __m256 svp[3] = {
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(svpData)),
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(svpData + 4)),
+        _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(svpData + 8))
+    };
+    for (int i = 0; i < count; i += 8) {
+        __m256 s, c;
+        sincosAvx2(_mm256_loadu_ps(rotation + i), &s, &c);
+        const __m256 x = _mm256_loadu_ps(tx + i);
+        const __m256 y = _mm256_loadu_ps(ty + i);
+        const __m256 z = _mm256_loadu_ps(tz + i);
+        const int n = qMin(8, count - i);
+        for (int k = 0; k < n; k += 2) {
+            const __m256i lanes = _mm256_setr_epi32(k, k, k, k, k + 1, k + 1, k + 1, k + 1);
+            const __m256 sk = _mm256_permutevar8x32_ps(s, lanes);
+            const __m256 ck = _mm256_permutevar8x32_ps(c, lanes);
+            const __m256 col0 = _mm256_sub_ps(_mm256_mul_ps(ck, svp[0]), _mm256_mul_ps(sk, svp[2]));
+            const __m256 col2 = _mm256_add_ps(_mm256_mul_ps(sk, svp[0]), _mm256_mul_ps(ck, svp[2]));
+            const __m256 col3 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_permutevar8x32_ps(x, lanes), vp[0]),
+                                                            _mm256_mul_ps(_mm256_permutevar8x32_ps(y, lanes), vp[1])),
+                                              _mm256_add_ps(_mm256_mul_ps(_mm256_permutevar8x32_ps(z, lanes), vp[2]), vp[3]));
+            float *m = reinterpret_cast<float *>(dst + qsizetype(i + k) * stride);
+            _mm_storeu_ps(m, _mm256_castps256_ps128(col0));
+            _mm_storeu_ps(m + 4, _mm256_castps256_ps128(svp[1]));
+            _mm_storeu_ps(m + 8, _mm256_castps256_ps128(col2));
+            _mm_storeu_ps(m + 12, _mm256_castps256_ps128(col3));
+            if (k + 1 < n) {
+                m = reinterpret_cast<float *>(reinterpret_cast<char *>(m) + stride);
+                _mm_storeu_ps(m, _mm256_extractf128_ps(col0, 1));
+                _mm_storeu_ps(m + 4, _mm256_extractf128_ps(svp[1], 1));
+                _mm_storeu_ps(m + 8, _mm256_extractf128_ps(col2, 1));
+                _mm_storeu_ps(m + 12, _mm256_extractf128_ps(col3, 1));
+            }
+        }
+    }
+}
+
+#endif // AVX2
+#endif // Q_PROCESSOR_X86
+
+bool ObjectTransforms::isKernelSupported(Kernel kernel)
+{
+    switch (kernel) {
+    case AutoKernel:
+    case ScalarKernel:
+        return true;
+#ifdef Q_PROCESSOR_X86
+    case Sse2Kernel:
+        return true; // Qt 6 requires SSE2 on x86
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    case Avx2Kernel:
+        return qCpuHasFeature(AVX2);
+#endif
+#endif
+    default:
+        break;
+    }
+    return false;
+}
+
+void ObjectTransforms::calculateMvps(const QMatrix4x4 &viewProjection, void *dst, int stride, Kernel kernel) const
+{
+    if (kernel == AutoKernel) {
+        if (isKernelSupported(Avx2Kernel))
+            kernel = Avx2Kernel;
+        else if (isKernelSupported(Sse2Kernel))
+            kernel = Sse2Kernel;
+        else
+            kernel = ScalarKernel;
+    } else if (!isKernelSupported(kernel)) {
+        kernel = ScalarKernel;
+    }
+
+    const float *vp = viewProjection.constData();
+    float svp[12];
+    for (int i = 0; i < 12; ++i)
+        svp[i] = vp[i] * m_scale;
+    char *d = static_cast<char *>(dst);
+    switch (kernel) {
+#ifdef Q_PROCESSOR_X86
+    case Sse2Kernel:
+        calculateMvpsSse2(vp, svp, m_rotation.data(), m_x.data(), m_y.data(), m_z.data(), m_count, d, stride);
+        break;
+#if QT_COMPILER_SUPPORTS_HERE(AVX2)
+    case Avx2Kernel:
+        calculateMvpsAvx2(vp, svp, m_rotation.data(), m_x.data(), m_y.data(), m_z.data(), m_count, d, stride);
+        break;
+#endif
+#endif
+    default:
+        calculateMvpsScalar(vp, svp, m_rotation.data(), m_x.data(), m_y.data(), m_z.data(), m_count, d, stride);
+        break;
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef TRANSFORMS_H
+#define TRANSFORMS_H
+
+#include <QMatrix4x4>
+#include <vector>
+
+// Rotation (around the Y axis, in radians) and translation for many objects,
+// in struct-of-arrays form, so that the model-view-projection matrices can be
+// calculated for multiple objects at once with SSE2 or AVX2, instead of one
+// by one with QMatrix4x4::translate() and rotate(). The results are written
+// as column-major mat4s, ready to be uploaded to a std140 uniform (or storage)
+// buffer.
+class ObjectTransforms
+{
+public:
+    enum Kernel {
+        AutoKernel,     // the best one the CPU supports
+        ScalarKernel,
+        Sse2Kernel,
+        Avx2Kernel
+    };
+
+    void resize(int count);
+    int count() const { return m_count; }
+
+    float *rotations() { return m_rotation.data(); }
+    float *translationsX() { return m_x.data(); }
+    float *translationsY() { return m_y.data(); }
+    float *translationsZ() { return m_z.data(); }
+
+    // uniform scale, the same for all objects
+    void setScale(float scale) { m_scale = scale; }
+    float scale() const { return m_scale; }
+
+    static bool isKernelSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+
+    // Writes viewProjection * translate(x, y, z) * rotate(angle, 0, 1, 0)
+    // * scale(s) for each object to dst, with stride bytes between the matrices (64 for
+    // a tightly packed std140 mat4 array, ubufAligned(64) for use with
+    // dynamic offsets).
+    void calculateMvps(const QMatrix4x4 &viewProjection, void *dst, int stride, Kernel kernel = AutoKernel) const;
+
+private:
+    int m_count = 0;
+    float m_scale = 1.0f;
+    // padded with zeroes up to a multiple of 8, so the SIMD kernels can always
+    // load full vectors
+    std::vector<float> m_rotation;
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+};
+
+#endif
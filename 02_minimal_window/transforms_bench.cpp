@@ -0,0 +1,124 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+// Microbenchmark for ObjectTransforms: calculates the model-view-projection
+// matrices for 1K, 100K, and 1M objects with QMatrix4x4 (one object at a
+// time, like the render() functions in the examples do), and with each of the
+// ObjectTransforms kernels, and prints the median time and the speedup. The
+// output of each kernel is compared to the QMatrix4x4 results, and the exit
+// code is 1 when any of them differs by more than the tolerance.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtMath>
+#include "transforms.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static qint64 median(std::vector<qint64> nsecs)
+{
+    std::sort(nsecs.begin(), nsecs.end());
+    return nsecs[nsecs.size() / 2];
+}
+
+// largest absolute difference between the matrices in a and b
+static float maxAbsDiff(const std::vector<char> &a, const std::vector<char> &b, int count, int stride)
+{
+    float result = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        const float *ma = reinterpret_cast<const float *>(a.data() + size_t(i) * stride);
+        const float *mb = reinterpret_cast<const float *>(b.data() + size_t(i) * stride);
+        for (int j = 0; j < 16; ++j)
+            result = qMax(result, std::fabs(ma[j] - mb[j]));
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption iterationsOption({ "i", "iterations" }, QLatin1String("Number of runs per measurement (default 21)"), QLatin1String("count"), QLatin1String("21"));
+    cmdLineParser.addOption(iterationsOption);
+    QCommandLineOption strideOption("stride", QLatin1String("Bytes between the matrices in the output (default 64)"), QLatin1String("bytes"), QLatin1String("64"));
+    cmdLineParser.addOption(strideOption);
+    cmdLineParser.process(app);
+
+    const int iterations = qMax(1, cmdLineParser.value(iterationsOption).toInt());
+    const int stride = qMax(64, cmdLineParser.value(strideOption).toInt());
+    // the matrix elements are at most a few tens, so this is a few ulps
+    const float tolerance = 1e-4f;
+    const float scale = 0.5f;
+    bool failed = false;
+
+    QMatrix4x4 viewProjection;
+    viewProjection.perspective(45.0f, 16.0f / 9.0f, 0.01f, 1000.0f);
+    viewProjection.translate(0, 0, -4);
+
+    const ObjectTransforms::Kernel kernels[] = {
+        ObjectTransforms::ScalarKernel,
+        ObjectTransforms::Sse2Kernel,
+        ObjectTransforms::Avx2Kernel
+    };
+
+    printf("%10s %12s %12s %8s %12s\n", "objects", "path", "median_us", "speedup", "max_diff");
+    for (int count : { 1000, 100000, 1000000 }) {
+        ObjectTransforms transforms;
+        transforms.resize(count);
+        transforms.setScale(scale);
+        QRandomGenerator rand(count);
+        for (int i = 0; i < count; ++i) {
+            transforms.rotations()[i] = float(rand.bounded(2.0 * M_PI));
+            transforms.translationsX()[i] = float(rand.bounded(20.0) - 10.0);
+            transforms.translationsY()[i] = float(rand.bounded(20.0) - 10.0);
+            transforms.translationsZ()[i] = float(rand.bounded(20.0) - 10.0);
+        }
+        std::vector<char> reference(size_t(count) * stride);
+        std::vector<char> dst(size_t(count) * stride);
+        std::vector<qint64> nsecs(iterations);
+        QElapsedTimer timer;
+
+        for (int it = 0; it < iterations; ++it) {
+            timer.start();
+            for (int i = 0; i < count; ++i) {
+                QMatrix4x4 mvp = viewProjection;
+                mvp.translate(transforms.translationsX()[i], transforms.translationsY()[i], transforms.translationsZ()[i]);
+                mvp.rotate(qRadiansToDegrees(transforms.rotations()[i]), 0, 1, 0);
+                mvp.scale(scale);
+                memcpy(reference.data() + size_t(i) * stride, mvp.constData(), 64);
+            }
+            nsecs[it] = timer.nsecsElapsed();
+        }
+        const qint64 baseline = median(nsecs);
+        printf("%10d %12s %12.1f %8.2f %12s\n", count, "QMatrix4x4", baseline / 1000.0, 1.0, "-");
+
+        for (ObjectTransforms::Kernel kernel : kernels) {
+            if (!ObjectTransforms::isKernelSupported(kernel)) {
+                printf("%10d %12s %12s\n", count, ObjectTransforms::kernelName(kernel), "unsupported");
+                continue;
+            }
+            std::fill(dst.begin(), dst.end(), 0);
+            for (int it = 0; it < iterations; ++it) {
+                timer.start();
+                transforms.calculateMvps(viewProjection, dst.data(), stride, kernel);
+                nsecs[it] = timer.nsecsElapsed();
+            }
+            const qint64 t = median(nsecs);
+            const float diff = maxAbsDiff(reference, dst, count, stride);
+            printf("%10d %12s %12.1f %8.2f %12g\n", count, ObjectTransforms::kernelName(kernel), t / 1000.0, double(baseline) / qMax<qint64>(1, t), diff);
+            if (!(diff <= tolerance)) {
+                fprintf(stderr, "%s: results differ from QMatrix4x4 by %g (tolerance %g)\n",
+                        ObjectTransforms::kernelName(kernel), diff, tolerance);
+                failed = true;
+            }
+        }
+    }
+
+    return failed ? 1 : 0;
+}
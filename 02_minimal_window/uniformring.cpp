@@ -0,0 +1,38 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "uniformring.h"
+
+bool UniformRing::create(QRhi *rhi, quint32 blockSize, int blockCount)
+{
+    m_blockSize = blockSize;
+    m_stride = rhi->ubufAligned(blockSize);
+    m_blockCount = blockCount;
+    m_used = 0;
+
+    // the old buffer, if any, may still be in use by frames in flight, QRhi
+    // defers the actual release as appropriate
+    m_buf.reset(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, m_stride * quint32(blockCount)));
+    if (!m_buf->create())
+        return false;
+
+    m_data.resize(m_buf->size());
+    return true;
+}
+
+qint64 UniformRing::allocate(int count)
+{
+    const quint32 size = m_stride * quint32(count);
+    if (count <= 0 || m_used + size > quint32(m_data.size()))
+        return -1;
+
+    const quint32 offset = m_used;
+    m_used += size;
+    return offset;
+}
+
+void UniformRing::commit(QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (m_used)
+        resourceUpdates->updateDynamicBuffer(m_buf.get(), 0, m_used, m_data.constData());
+}
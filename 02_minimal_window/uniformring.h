@@ -0,0 +1,47 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef UNIFORMRING_H
+#define UNIFORMRING_H
+
+#include <rhi/qrhi.h>
+
+// Sub-allocates the uniform data of many draw calls from one large Dynamic
+// uniform buffer. Each block starts at a multiple of ubufAlignment(), so that
+// a single QRhiShaderResourceBindings, with uniformBufferWithDynamicOffset(),
+// serves all the draws, with the offset passed to setShaderResources().
+//
+// The data is written to a CPU-side copy first and goes up with a single
+// updateDynamicBuffer() in commit(). Dynamic buffers are backed by one native
+// buffer per frame in flight, so the allocator can start from the beginning
+// in every frame.
+class UniformRing
+{
+public:
+    bool create(QRhi *rhi, quint32 blockSize, int blockCount);
+
+    QRhiBuffer *buffer() const { return m_buf.get(); }
+    quint32 blockSize() const { return m_blockSize; }
+    quint32 stride() const { return m_stride; }
+    int blockCount() const { return m_blockCount; }
+
+    // call at the start of each frame
+    void reset() { m_used = 0; }
+
+    // Allocates count consecutive blocks, stride() bytes apart. Returns the
+    // offset of the first one, or -1 if there is not enough space left.
+    qint64 allocate(int count = 1);
+    char *data(quint32 offset) { return m_data.data() + offset; }
+
+    void commit(QRhiResourceUpdateBatch *resourceUpdates);
+
+private:
+    std::unique_ptr<QRhiBuffer> m_buf;
+    QByteArray m_data;
+    quint32 m_blockSize = 0;
+    quint32 m_stride = 0;
+    int m_blockCount = 0;
+    quint32 m_used = 0;
+};
+
+#endif
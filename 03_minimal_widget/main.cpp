@@ -2,9 +2,12 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
 #include <QRhiWidget>
 #include <QPushButton>
 #include <QFile>
+#include <QKeyEvent>
 #include <rhi/qrhi.h>
 
 class ExampleRhiWidget : public QRhiWidget
@@ -14,6 +17,17 @@ public:
     void initialize(QRhiCommandBuffer *cb) override;
     void render(QRhiCommandBuffer *cb) override;
 
+    // On demand: the rotation is time based, and a new frame is requested
+    // only while animating, otherwise only resizes and exposes (handled by
+    // QRhiWidget) lead to rendering. Space toggles the animation.
+    void setOnDemandEnabled(bool enable) { m_onDemand = enable; }
+    void setAnimating(bool animating);
+    quint64 framesRendered() const { return m_framesRendered; }
+    quint64 framesNeeded() const { return m_framesNeeded; }
+
+protected:
+    void keyPressEvent(QKeyEvent *e) override;
+
 private:
     QRhi *m_rhi = nullptr;
     std::unique_ptr<QRhiBuffer> m_vbuf;
@@ -22,6 +36,15 @@ private:
     std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
     QMatrix4x4 m_viewProjection;
     float m_rotation = 0.0f;
+
+    bool m_onDemand = false;
+    bool m_animating = true;
+    bool m_dirty = true;
+    QElapsedTimer m_animationTimer;
+    // a frame is needed when the animation is running or something else
+    // (size, exposure) changed since the previous one
+    quint64 m_framesRendered = 0;
+    quint64 m_framesNeeded = 0;
 };
 
 void ExampleRhiWidget::initialize(QRhiCommandBuffer *cb)
@@ -73,16 +96,54 @@ void ExampleRhiWidget::initialize(QRhiCommandBuffer *cb)
         cb->resourceUpdate(resourceUpdates);
     }
 
+    // called on resize as well
+    m_dirty = true;
+
     const QSize outputSize = colorTexture()->pixelSize();
     m_viewProjection = m_rhi->clipSpaceCorrMatrix();
     m_viewProjection.perspective(45.0f, outputSize.width() / (float) outputSize.height(), 0.01f, 1000.0f);
     m_viewProjection.translate(0, 0, -4);
 }
 
+// Unlike minimal_window, the QRhi is not created by us, so there is no way to
+// request QRhi::EnablePipelineCacheDataSave, and pipelineCacheData() is always
+// empty. Hence no persistent pipeline cache in this example.
+
+void ExampleRhiWidget::setAnimating(bool animating)
+{
+    if (m_animating == animating)
+        return;
+
+    m_animating = animating;
+    m_animationTimer.invalidate();
+    update();
+}
+
+void ExampleRhiWidget::keyPressEvent(QKeyEvent *e)
+{
+    if (e->key() == Qt::Key_Space)
+        setAnimating(!m_animating);
+    else
+        QRhiWidget::keyPressEvent(e);
+}
+
 void ExampleRhiWidget::render(QRhiCommandBuffer *cb)
 {
+    ++m_framesRendered;
+    if (m_dirty || m_animating)
+        ++m_framesNeeded;
+    m_dirty = false;
+
     QRhiResourceUpdateBatch *resourceUpdates = m_rhi->nextResourceUpdateBatch();
-    m_rotation += 1.0f;
+    if (m_onDemand) {
+        // 60 degrees per second, regardless of how often frames are rendered
+        if (m_animating && m_animationTimer.isValid())
+            m_rotation += m_animationTimer.nsecsElapsed() / 1000000000.0f * 60.0f;
+        if (m_animating)
+            m_animationTimer.start();
+    } else if (m_animating) {
+        m_rotation += 1.0f;
+    }
     QMatrix4x4 modelViewProjection = m_viewProjection;
     modelViewProjection.rotate(m_rotation, 0, 1, 0);
     resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, modelViewProjection.constData());
@@ -100,15 +161,47 @@ void ExampleRhiWidget::render(QRhiCommandBuffer *cb)
 
     cb->endPass();
 
-    update();
+    if (!m_onDemand || m_animating)
+        update();
 }
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QApplication app(argc, argv);
+
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption onDemandOption("on-demand", QLatin1String("Render only when something changed, with a time based animation (toggled with Space)"));
+    cmdLineParser.addOption(onDemandOption);
+    QCommandLineOption noAnimationOption("no-animation", QLatin1String("Start with the animation stopped"));
+    cmdLineParser.addOption(noAnimationOption);
+    cmdLineParser.process(app);
+
     ExampleRhiWidget rhiWidget;
     rhiWidget.resize(1280, 720);
+    rhiWidget.setFocusPolicy(Qt::StrongFocus);
+    rhiWidget.setOnDemandEnabled(cmdLineParser.isSet(onDemandOption));
+    if (cmdLineParser.isSet(noAnimationOption))
+        rhiWidget.setAnimating(false);
     new QPushButton("This is a QPushButton", &rhiWidget);
+
+    if (cmdLineParser.isSet(reportStartupOption)) {
+        QObject::connect(&rhiWidget, &QRhiWidget::frameSubmitted, &rhiWidget, [startupTimer] {
+            qDebug("Time to first frame: %lld ms", startupTimer.elapsed());
+        }, Qt::SingleShotConnection);
+    }
+
     rhiWidget.show();
-    return app.exec();
+
+    const int ret = app.exec();
+
+    if (cmdLineParser.isSet(onDemandOption))
+        qDebug("Frames rendered: %llu, needed: %llu", rhiWidget.framesRendered(), rhiWidget.framesNeeded());
+
+    return ret;
 }
@@ -0,0 +1,17 @@
+#version 440
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 color;
+// per instance
+layout(location = 2) in vec4 mvpCol0;
+layout(location = 3) in vec4 mvpCol1;
+layout(location = 4) in vec4 mvpCol2;
+layout(location = 5) in vec4 mvpCol3;
+
+layout(location = 0) out vec3 v_color;
+
+void main()
+{
+    v_color = color;
+    gl_Position = mat4(mvpCol0, mvpCol1, mvpCol2, mvpCol3) * position;
+}
@@ -2,16 +2,160 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QQuickGraphicsConfiguration>
 #include <QQuickView>
+#include <QStandardPaths>
+#include "rhiunderlay.h"
+
+static QString pipelineCacheFileName()
+{
+    // one file per graphics API, Qt Quick validates the contents itself
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QString::asprintf("/pipelinecache_%d.bin", int(QQuickWindow::graphicsApi()));
+}
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame, and if the pipeline cache was used"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption noBatchingOption("no-batching", QLatin1String("Use a separate pipeline and draw call for each RhiUnderlay"));
+    cmdLineParser.addOption(noBatchingOption);
+    QCommandLineOption underlaysOption("underlays", QLatin1String("Show N RhiUnderlays instead"), QLatin1String("N"));
+    cmdLineParser.addOption(underlaysOption);
+    QCommandLineOption frameTimingOption("frame-timing", QLatin1String("Print the average frame time and the time spent in rendering the scene on the render thread every second"));
+    cmdLineParser.addOption(frameTimingOption);
+    QCommandLineOption blockingSyncOption("blocking-sync", QLatin1String("Copy the RhiUnderlay parameters to the renderer while the main thread is blocked, instead of using lock-free snapshots"));
+    cmdLineParser.addOption(blockingSyncOption);
+    QCommandLineOption syncTimingOption("sync-timing", QLatin1String("Print the average time the main thread is blocked for synchronizing every second, and the number of window updates on exit"));
+    cmdLineParser.addOption(syncTimingOption);
+    cmdLineParser.process(app);
+
+    RhiUnderlay::setBatchingEnabled(!cmdLineParser.isSet(noBatchingOption));
+    RhiUnderlay::setSnapshotsEnabled(!cmdLineParser.isSet(blockingSyncOption));
+
     QQuickView view;
+
+    // Qt Quick sets EnablePipelineCacheDataSave and does the loading and saving
+    const QString pipelineCacheFile = pipelineCacheFileName();
+    const bool pipelineCacheWarm = QFileInfo::exists(pipelineCacheFile);
+    QDir().mkpath(QFileInfo(pipelineCacheFile).absolutePath());
+    QQuickGraphicsConfiguration config;
+    config.setPipelineCacheLoadFile(pipelineCacheFile);
+    config.setPipelineCacheSaveFile(pipelineCacheFile);
+    view.setGraphicsConfiguration(config);
+
+    if (cmdLineParser.isSet(reportStartupOption)) {
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [startupTimer, pipelineCacheWarm] {
+            qDebug("Time to first frame: %lld ms (pipeline cache %s)", startupTimer.elapsed(),
+                   pipelineCacheWarm ? "warm" : "cold");
+        }, Qt::SingleShotConnection);
+    }
+
+    // Everything here happens on the render thread, if there is one. The
+    // render time is the CPU time from the start of preparing the frame to the
+    // end of recording the render pass (which includes updating and drawing
+    // the underlays), so that is what differs between the per-item and
+    // batched paths. With vsync, the frame time will mostly stay the same.
+    struct {
+        QElapsedTimer frameTimer;
+        QElapsedTimer renderTimer;
+        qint64 renderTime = 0;
+        int frameCount = 0;
+    } frameTiming;
+    if (cmdLineParser.isSet(frameTimingOption)) {
+        QObject::connect(&view, &QQuickWindow::beforeRendering, &view, [&frameTiming] {
+            frameTiming.renderTimer.start();
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::afterRenderPassRecording, &view, [&frameTiming] {
+            frameTiming.renderTime += frameTiming.renderTimer.nsecsElapsed();
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [&frameTiming] {
+            if (!frameTiming.frameTimer.isValid()) {
+                frameTiming.frameTimer.start();
+                frameTiming.renderTime = 0;
+                return;
+            }
+            ++frameTiming.frameCount;
+            if (frameTiming.frameTimer.elapsed() >= 1000) {
+                qDebug("%d frames, average frame time %.2f ms, render %.3f ms",
+                       frameTiming.frameCount,
+                       frameTiming.frameTimer.nsecsElapsed() / 1000000.0 / frameTiming.frameCount,
+                       frameTiming.renderTime / 1000000.0 / frameTiming.frameCount);
+                frameTiming.frameCount = 0;
+                frameTiming.renderTime = 0;
+                frameTiming.frameTimer.restart();
+            }
+        }, Qt::DirectConnection);
+    }
+
+    // afterAnimating is emitted on the main thread right before it requests
+    // the render thread (if there is one) to synchronize, and then blocks
+    // until afterSynchronizing, so the difference between the two is the
+    // time the main thread is blocked. (not counting the time to wake up) The
+    // timer is only read from the two threads, which is safe.
+    struct {
+        QElapsedTimer clock;
+        QAtomicInteger<qint64> animatingDone;
+        qint64 syncStart = 0;
+        qint64 blockedTime = 0;
+        qint64 syncTime = 0;
+        qint64 lastReport = 0;
+        int syncCount = 0;
+    } syncTiming;
+    if (cmdLineParser.isSet(syncTimingOption)) {
+        syncTiming.clock.start();
+        QObject::connect(&view, &QQuickWindow::afterAnimating, &view, [&syncTiming] {
+            syncTiming.animatingDone.storeRelease(syncTiming.clock.nsecsElapsed());
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::beforeSynchronizing, &view, [&syncTiming] {
+            syncTiming.syncStart = syncTiming.clock.nsecsElapsed();
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::afterSynchronizing, &view, [&syncTiming] {
+            const qint64 now = syncTiming.clock.nsecsElapsed();
+            // the first few syncs may happen without animating
+            const qint64 animatingDone = syncTiming.animatingDone.loadAcquire();
+            syncTiming.blockedTime += now - (animatingDone ? animatingDone : syncTiming.syncStart);
+            syncTiming.syncTime += now - syncTiming.syncStart;
+            ++syncTiming.syncCount;
+            if (now - syncTiming.lastReport >= 1000000000) {
+                qDebug("%d syncs, main thread blocked on average %.3f ms, of which syncing %.3f ms",
+                       syncTiming.syncCount,
+                       syncTiming.blockedTime / 1000000.0 / syncTiming.syncCount,
+                       syncTiming.syncTime / 1000000.0 / syncTiming.syncCount);
+                syncTiming.blockedTime = 0;
+                syncTiming.syncTime = 0;
+                syncTiming.syncCount = 0;
+                syncTiming.lastReport = now;
+            }
+        }, Qt::DirectConnection);
+    }
+
     view.setResizeMode(QQuickView::SizeRootObjectToView);
-    view.setSource(QUrl("qrc:///main.qml"));
+    if (cmdLineParser.isSet(underlaysOption)) {
+        view.setInitialProperties({ { QLatin1String("underlayCount"), qMax(1, cmdLineParser.value(underlaysOption).toInt()) } });
+        view.setSource(QUrl("qrc:///underlays.qml"));
+    } else {
+        view.setSource(QUrl("qrc:///main.qml"));
+    }
     view.show();
 
-    return app.exec();
+    const int ret = app.exec();
+
+    if (cmdLineParser.isSet(syncTimingOption)) {
+        qDebug("RhiUnderlay parameter changes: %llu, window updates requested: %llu",
+               RhiUnderlay::parameterChangeCount(), RhiUnderlay::windowUpdateCount());
+    }
+
+    return ret;
 }
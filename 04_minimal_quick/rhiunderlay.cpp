@@ -2,18 +2,65 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include "rhiunderlay.h"
+#include "underlaymanager.h"
 #include <QtQuick/QQuickWindow>
 #include <QtCore/QFile>
 #include <QtCore/QRunnable>
 
+static bool batchingEnabled = true;
+static bool snapshotsEnabled = true;
+static QAtomicInteger<quint64> parameterChanges;
+static QAtomicInteger<quint64> windowUpdates;
+
+void RhiUnderlay::setBatchingEnabled(bool enable)
+{
+    batchingEnabled = enable;
+}
+
+void RhiUnderlay::setSnapshotsEnabled(bool enable)
+{
+    snapshotsEnabled = enable;
+}
+
+bool RhiUnderlay::isSnapshotsEnabled()
+{
+    return snapshotsEnabled;
+}
+
+quint64 RhiUnderlay::parameterChangeCount()
+{
+    return parameterChanges.loadRelaxed();
+}
+
+quint64 RhiUnderlay::windowUpdateCount()
+{
+    return windowUpdates.loadRelaxed();
+}
+
 RhiUnderlay::RhiUnderlay()
+    : m_channel(std::make_shared<UnderlayChannel>())
 {
     connect(this, &QQuickItem::windowChanged, this, &RhiUnderlay::handleWindowChanged);
 }
 
+RhiUnderlay::~RhiUnderlay()
+{
+    if (m_manager)
+        m_manager->removeUnderlay(this);
+}
+
 void RhiUnderlay::handleWindowChanged(QQuickWindow *win)
 {
-    if (win) {
+    if (m_manager) {
+        m_manager->removeUnderlay(this);
+        m_manager = nullptr;
+    }
+
+    if (win && batchingEnabled) {
+        m_manager = UnderlayManager::get(win);
+        m_manager->addUnderlay(this);
+        win->setColor(QColor::fromRgbF(0.4f, 0.7f, 0.0f, 1.0f));
+    } else if (win) {
         connect(win, &QQuickWindow::beforeSynchronizing, this, &RhiUnderlay::sync, Qt::DirectConnection);
         connect(win, &QQuickWindow::sceneGraphInvalidated, this, &RhiUnderlay::cleanup, Qt::DirectConnection);
         win->setColor(QColor::fromRgbF(0.4f, 0.7f, 0.0f, 1.0f));
@@ -45,6 +92,9 @@ private:
 
 void RhiUnderlay::releaseResources()
 {
+    if (!m_renderer)
+        return;
+
     window()->scheduleRenderJob(new CleanupJob(m_renderer), QQuickWindow::BeforeSynchronizingStage);
     m_renderer = nullptr;
 }
@@ -57,10 +107,26 @@ void RhiUnderlay::setAngle(float a)
     m_angle = a;
     emit angleChanged();
 
+    parameterChanges.fetchAndAddRelaxed(1);
+
+    // With snapshots, the renderer reads the parameters from the channel at
+    // the start of the frame, so there is only need for a new frame if the
+    // previous parameters have been picked up already. (with many updates per
+    // frame, e.g. from multiple animations or input events, the rest is
+    // coalesced)
+    if (snapshotsEnabled) {
+        UnderlayParams params;
+        params.angle = m_angle;
+        if (!m_channel->publish(params))
+            return;
+    }
+
     // update() (as in QQuickItem's) is not sufficient here; RhiUnderlay is not
     // a proper visual Item, so use the window's update() instead
-    if (window())
+    if (window()) {
+        windowUpdates.fetchAndAddRelaxed(1);
         window()->update();
+    }
 }
 
 void RhiUnderlay::sync()
@@ -76,8 +142,10 @@ void RhiUnderlay::sync()
         // beforeRenderPassRecording. Changing to afterRenderPassRecording
         // would render the Underlay on top (overlay).
         connect(window(), &QQuickWindow::beforeRenderPassRecording, m_renderer, &UnderlayRenderer::mainPassRecordingStart, Qt::DirectConnection);
+        m_renderer->setChannel(m_channel);
     }
-    m_renderer->setAngle(m_angle);
+    if (!snapshotsEnabled)
+        m_renderer->setAngle(m_angle);
     m_renderer->setWindow(window());
 }
 
@@ -97,6 +165,9 @@ void UnderlayRenderer::frameStart()
         return;
     }
 
+    if (RhiUnderlay::isSnapshotsEnabled())
+        m_angle = m_channel->read().angle;
+
     QRhiResourceUpdateBatch *resourceUpdates = rhi->nextResourceUpdateBatch();
 
     if (!m_pipeline) {
@@ -6,9 +6,12 @@
 
 #include <QQuickWindow>
 #include <QQuickItem>
+#include <QPointer>
 #include <rhi/qrhi.h>
+#include "underlaychannel.h"
 
 class UnderlayRenderer;
+class UnderlayManager;
 
 // derives from QQuickItem, instances live on the main thread
 class RhiUnderlay : public QQuickItem
@@ -19,10 +22,29 @@ class RhiUnderlay : public QQuickItem
 
 public:
     RhiUnderlay();
+    ~RhiUnderlay();
 
     float angle() const { return m_angle; }
     void setAngle(float a);
 
+    // Render all RhiUnderlays in a window with an UnderlayManager (the
+    // default), instead of an UnderlayRenderer per item. Applies to items
+    // added to a window afterwards.
+    static void setBatchingEnabled(bool enable);
+
+    // Pass the parameters to the renderer via an UnderlayChannel (the
+    // default), instead of copying them in sync(), while the main thread is
+    // blocked.
+    static void setSnapshotsEnabled(bool enable);
+    static bool isSnapshotsEnabled();
+
+    std::shared_ptr<UnderlayChannel> channel() const { return m_channel; }
+
+    // number of setAngle() calls, and the number of window updates requested
+    // by them, to see how many got coalesced
+    static quint64 parameterChangeCount();
+    static quint64 windowUpdateCount();
+
 signals:
     void angleChanged();
 
@@ -37,6 +59,9 @@ private:
     void releaseResources() override;
 
     UnderlayRenderer *m_renderer = nullptr;
+    // the manager is a child of the window, and may be gone before the item
+    QPointer<UnderlayManager> m_manager;
+    std::shared_ptr<UnderlayChannel> m_channel;
     float m_angle = 0.0f;
 };
 
@@ -48,6 +73,7 @@ class UnderlayRenderer : public QObject
 public:
     void setWindow(QQuickWindow *window) { m_window = window; }
     void setAngle(float a) { m_angle = a; }
+    void setChannel(std::shared_ptr<UnderlayChannel> channel) { m_channel = channel; }
 
 public slots:
     void frameStart();
@@ -56,6 +82,7 @@ public slots:
 private:
     QQuickWindow *m_window;
     float m_angle = 0.0f;
+    std::shared_ptr<UnderlayChannel> m_channel;
 
     std::unique_ptr<QRhiBuffer> m_vbuf;
     std::unique_ptr<QRhiBuffer> m_ubuf;
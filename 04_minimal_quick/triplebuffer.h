@@ -0,0 +1,49 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+// Lock-free exchange of a value between one writer and one reader thread.
+// The writer fills writeBuffer() and calls publish(), the reader calls
+// update() and then looks at readBuffer(). Neither side ever waits for the
+// other: the third buffer is the one in the middle, holding the most recently
+// published value. The reader always sees a complete value, the latest one as
+// of its update() call, intermediate ones are skipped.
+template <typename T>
+class TripleBuffer
+{
+public:
+    T &writeBuffer() { return m_buffers[m_writeIndex]; }
+
+    void publish()
+    {
+        m_writeIndex = m_middle.fetchAndStoreAcqRel(m_writeIndex | FRESH) & INDEX_MASK;
+    }
+
+    // Returns true if there was a newly published value.
+    bool update()
+    {
+        if (!(m_middle.loadAcquire() & FRESH))
+            return false;
+        m_readIndex = m_middle.fetchAndStoreAcqRel(m_readIndex) & INDEX_MASK;
+        return true;
+    }
+
+    const T &readBuffer() const { return m_buffers[m_readIndex]; }
+
+    // for initialization only, before the threads start using it
+    T *buffers() { return m_buffers; }
+
+private:
+    static const int INDEX_MASK = 0x3;
+    static const int FRESH = 0x4;
+    T m_buffers[3];
+    int m_writeIndex = 0;
+    int m_readIndex = 1;
+    QAtomicInt m_middle = 2;
+};
+
+#endif
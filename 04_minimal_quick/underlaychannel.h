@@ -0,0 +1,46 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef UNDERLAYCHANNEL_H
+#define UNDERLAYCHANNEL_H
+
+#include "triplebuffer.h"
+
+// everything the renderer needs from a RhiUnderlay
+struct UnderlayParams
+{
+    float angle = 0.0f;
+};
+
+// Hands the parameters of a RhiUnderlay over from the main thread to the
+// render thread without going through sync(), where the main thread is
+// blocked. Shared by the item and the renderer, so either may go away first.
+class UnderlayChannel
+{
+public:
+    // Called on the main thread. Returns false if the render thread has not
+    // yet picked up the previously published parameters, meaning a window
+    // update is already pending and there is no need to request another one.
+    bool publish(const UnderlayParams &params)
+    {
+        m_buffer.writeBuffer() = params;
+        m_buffer.publish();
+        return m_updatePending.testAndSetOrdered(0, 1);
+    }
+
+    // Called on the render thread, returns the most recently published
+    // parameters. Clearing the flag first means that a publish() racing with
+    // this will at worst request one more, unnecessary, update.
+    const UnderlayParams &read()
+    {
+        m_updatePending.storeRelease(0);
+        m_buffer.update();
+        return m_buffer.readBuffer();
+    }
+
+private:
+    TripleBuffer<UnderlayParams> m_buffer;
+    QAtomicInt m_updatePending;
+};
+
+#endif
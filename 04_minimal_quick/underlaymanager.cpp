@@ -0,0 +1,241 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "underlaymanager.h"
+#include "rhiunderlay.h"
+#include <QtCore/QFile>
+
+UnderlayManager *UnderlayManager::get(QQuickWindow *window)
+{
+    UnderlayManager *manager = window->findChild<UnderlayManager *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!manager)
+        manager = new UnderlayManager(window);
+    return manager;
+}
+
+UnderlayManager::UnderlayManager(QQuickWindow *window)
+    : QObject(window),
+      m_window(window)
+{
+    connect(window, &QQuickWindow::beforeSynchronizing, this, &UnderlayManager::sync, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRendering, this, &UnderlayManager::frameStart, Qt::DirectConnection);
+    connect(window, &QQuickWindow::beforeRenderPassRecording, this, &UnderlayManager::mainPassRecordingStart, Qt::DirectConnection);
+    // The window destroys the scenegraph (and so emits this) before
+    // destroying its children, so the manager does not need to do anything
+    // special on destruction.
+    connect(window, &QQuickWindow::sceneGraphInvalidated, this, &UnderlayManager::releaseResources, Qt::DirectConnection);
+}
+
+void UnderlayManager::addUnderlay(RhiUnderlay *underlay)
+{
+    m_underlays.append(underlay);
+    m_underlaysChanged = true;
+    m_window->update();
+}
+
+void UnderlayManager::removeUnderlay(RhiUnderlay *underlay)
+{
+    m_underlays.removeOne(underlay);
+    m_underlaysChanged = true;
+    m_window->update();
+}
+
+void UnderlayManager::sync()
+{
+    // This function is invoked on the render thread, if there is one, while
+    // the main thread is blocked.
+
+    QRhi *rhi = m_window->rhi();
+    if (rhi && !rhi->isFeatureSupported(QRhi::Instancing)) {
+        if (!m_perItem) {
+            static bool warned = false;
+            if (!warned) {
+                qWarning("Instancing is not supported, rendering each RhiUnderlay separately");
+                warned = true;
+            }
+            m_perItem = true;
+            m_underlaysChanged = true;
+        }
+        syncRenderers();
+        return;
+    }
+
+    if (RhiUnderlay::isSnapshotsEnabled()) {
+        // the parameters are read in frameStart(), only the list of channels
+        // needs to be kept up to date here
+        if (m_underlaysChanged) {
+            m_channels.clear();
+            for (RhiUnderlay *underlay : std::as_const(m_underlays))
+                m_channels.push_back(underlay->channel());
+            m_underlaysChanged = false;
+        }
+        return;
+    }
+
+    m_angles.resize(m_underlays.count());
+    for (qsizetype i = 0; i < m_underlays.count(); ++i)
+        m_angles[i] = m_underlays[i]->angle();
+}
+
+void UnderlayManager::syncRenderers()
+{
+    if (m_underlaysChanged) {
+        m_renderers.resize(m_underlays.count());
+        for (qsizetype i = 0; i < m_underlays.count(); ++i) {
+            if (!m_renderers[i])
+                m_renderers[i] = std::make_unique<UnderlayRenderer>();
+            m_renderers[i]->setWindow(m_window);
+            m_renderers[i]->setChannel(m_underlays[i]->channel());
+        }
+        m_underlaysChanged = false;
+    }
+    if (!RhiUnderlay::isSnapshotsEnabled()) {
+        for (qsizetype i = 0; i < m_underlays.count(); ++i)
+            m_renderers[i]->setAngle(m_underlays[i]->angle());
+    }
+}
+
+void UnderlayManager::releaseResources()
+{
+    // the next QRhi may support instancing
+    m_renderers.clear();
+    m_perItem = false;
+    m_channels.clear();
+    m_underlaysChanged = true;
+    m_vbuf.reset();
+    m_instanceBuf.reset();
+    m_srb.reset();
+    m_pipeline.reset();
+    m_capacity = 0;
+}
+
+void UnderlayManager::frameStart()
+{
+    // This function is invoked on the render thread, if there is one.
+
+    if (m_perItem) {
+        for (const auto &renderer : m_renderers)
+            renderer->frameStart();
+        return;
+    }
+
+    if (RhiUnderlay::isSnapshotsEnabled()) {
+        m_angles.resize(m_channels.size());
+        for (size_t i = 0; i < m_channels.size(); ++i)
+            m_angles[i] = m_channels[i]->read().angle;
+    }
+
+    if (m_angles.isEmpty())
+        return;
+
+    QRhi *rhi = m_window->rhi();
+    if (!rhi) {
+        qWarning("QQuickWindow is not using QRhi for rendering");
+        return;
+    }
+
+    QRhiSwapChain *swapChain = m_window->swapChain();
+    if (!swapChain) {
+        qWarning("No QRhiSwapChain?");
+        return;
+    }
+
+    QRhiResourceUpdateBatch *resourceUpdates = rhi->nextResourceUpdateBatch();
+
+    if (!m_pipeline) {
+        static float vertexData[] = { // Y up, CCW
+            0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
+            -0.5f, -0.5f,     0.0f, 1.0f, 0.0f,
+            0.5f,  -0.5f,     0.0f, 0.0f, 1.0f,
+        };
+
+        m_vbuf.reset(rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(vertexData)));
+        m_vbuf->create();
+
+        // no uniforms, the matrices are per-instance vertex inputs
+        m_srb.reset(rhi->newShaderResourceBindings());
+        m_srb->create();
+
+        m_pipeline.reset(rhi->newGraphicsPipeline());
+        static auto getShader = [](const QString &name) {
+            QFile f(name);
+            return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+        };
+        m_pipeline->setShaderStages({
+            { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color_instanced.vert.qsb")) },
+            { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
+        });
+        QRhiVertexInputLayout inputLayout;
+        inputLayout.setBindings({
+            { 5 * sizeof(float) },
+            { 16 * sizeof(float), QRhiVertexInputBinding::PerInstance }
+        });
+        inputLayout.setAttributes({
+            { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+            { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) },
+            { 1, 2, QRhiVertexInputAttribute::Float4, 0 },
+            { 1, 3, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) },
+            { 1, 4, QRhiVertexInputAttribute::Float4, 8 * sizeof(float) },
+            { 1, 5, QRhiVertexInputAttribute::Float4, 12 * sizeof(float) }
+        });
+        m_pipeline->setVertexInputLayout(inputLayout);
+        m_pipeline->setShaderResourceBindings(m_srb.get());
+        m_pipeline->setRenderPassDescriptor(swapChain->currentFrameRenderTarget()->renderPassDescriptor());
+        m_pipeline->create();
+
+        resourceUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
+    }
+
+    const int count = m_angles.count();
+    if (count > m_capacity) {
+        // the old buffer may still be in use by frames in flight, QRhi defers
+        // the actual release as appropriate
+        m_capacity = qMax(count, m_capacity * 2);
+        m_instanceBuf.reset(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, m_capacity * 16 * sizeof(float)));
+        m_instanceBuf->create();
+    }
+
+    const QSize outputSizeInPixels = swapChain->currentFrameRenderTarget()->pixelSize();
+    QMatrix4x4 viewProjection = rhi->clipSpaceCorrMatrix();
+    viewProjection.perspective(45.0f, outputSizeInPixels.width() / (float) outputSizeInPixels.height(), 0.01f, 1000.0f);
+    viewProjection.translate(0, 0, -4);
+
+    m_instances.resize(size_t(count) * 16);
+    for (int i = 0; i < count; ++i) {
+        QMatrix4x4 modelViewProjection = viewProjection;
+        modelViewProjection.rotate(m_angles[i], 0, 1, 0);
+        memcpy(m_instances.data() + size_t(i) * 16, modelViewProjection.constData(), 16 * sizeof(float));
+    }
+    resourceUpdates->updateDynamicBuffer(m_instanceBuf.get(), 0, count * 16 * sizeof(float), m_instances.data());
+
+    swapChain->currentFrameCommandBuffer()->resourceUpdate(resourceUpdates);
+}
+
+void UnderlayManager::mainPassRecordingStart()
+{
+    // This function is invoked on the render thread, if there is one.
+
+    if (m_perItem) {
+        for (const auto &renderer : m_renderers)
+            renderer->mainPassRecordingStart();
+        return;
+    }
+
+    QRhi *rhi = m_window->rhi();
+    QRhiSwapChain *swapChain = m_window->swapChain();
+    if (!rhi || !swapChain || !m_pipeline || m_angles.isEmpty())
+        return;
+
+    const QSize outputSizeInPixels = swapChain->currentFrameRenderTarget()->pixelSize();
+    QRhiCommandBuffer *cb = swapChain->currentFrameCommandBuffer();
+
+    cb->setGraphicsPipeline(m_pipeline.get());
+    cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+    cb->setShaderResources();
+    const QRhiCommandBuffer::VertexInput vbufBindings[] = {
+        { m_vbuf.get(), 0 },
+        { m_instanceBuf.get(), 0 }
+    };
+    cb->setVertexInput(0, 2, vbufBindings);
+    cb->draw(3, m_angles.count());
+}
@@ -0,0 +1,59 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef UNDERLAYMANAGER_H
+#define UNDERLAYMANAGER_H
+
+#include <QQuickWindow>
+#include <rhi/qrhi.h>
+#include "rhiunderlay.h"
+#include <memory>
+#include <vector>
+
+// Renders all the RhiUnderlays in a window with one pipeline and a single
+// instanced draw call, instead of an UnderlayRenderer (with its own pipeline,
+// uniform buffer, and draw call) per item. Created on the main thread as a
+// child of the window; sync(), frameStart(), mainPassRecordingStart(), and
+// releaseResources() are invoked on the render thread, if there is one.
+// Without QRhi::Instancing (e.g. OpenGL ES 2.0), it falls back to an
+// UnderlayRenderer per item, like with --no-batching.
+class UnderlayManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static UnderlayManager *get(QQuickWindow *window);
+
+    void addUnderlay(RhiUnderlay *underlay);
+    void removeUnderlay(RhiUnderlay *underlay);
+
+public slots:
+    void sync();
+    void frameStart();
+    void mainPassRecordingStart();
+    void releaseResources();
+
+private:
+    UnderlayManager(QQuickWindow *window);
+    void syncRenderers();
+
+    QQuickWindow *m_window;
+    // only touched on the main thread, or in sync() when it is blocked
+    QList<RhiUnderlay *> m_underlays;
+    bool m_underlaysChanged = false;
+    // render thread
+    std::vector<std::shared_ptr<UnderlayChannel>> m_channels;
+    QList<float> m_angles;
+
+    std::unique_ptr<QRhiBuffer> m_vbuf;
+    std::unique_ptr<QRhiBuffer> m_instanceBuf;
+    std::unique_ptr<QRhiShaderResourceBindings> m_srb;
+    std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
+    std::vector<float> m_instances;
+    int m_capacity = 0;
+    // fallback when instancing is not supported
+    bool m_perItem = false;
+    std::vector<std::unique_ptr<UnderlayRenderer>> m_renderers;
+};
+
+#endif
@@ -0,0 +1,23 @@
+import QtQuick
+import QtQuick.Controls
+import TestApp
+
+// Many RhiUnderlays, see --underlays
+Item {
+    id: root
+    width: 1280
+    height: 720
+
+    property int underlayCount: 100
+
+    Button {
+        text: root.underlayCount + " underlays"
+    }
+
+    Repeater {
+        model: root.underlayCount
+        RhiUnderlay {
+            NumberAnimation on triangleRotation { from: index * 360 / root.underlayCount; to: index * 360 / root.underlayCount + 360; duration: 1500; loops: -1 }
+        }
+    }
+}
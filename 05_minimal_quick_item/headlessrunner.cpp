@@ -0,0 +1,200 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "headlessrunner.h"
+#include <QAnimationDriver>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QQuickGraphicsConfiguration>
+#include <QQmlComponent>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QQuickRenderControl>
+#include <QQuickRenderTarget>
+#include <QQuickWindow>
+#include <QVulkanInstance>
+#include <rhi/qrhi.h>
+#include <algorithm>
+#include <cstdio>
+
+// Makes the animations deterministic: time advances by a fixed amount with
+// each frame, no matter how long rendering takes.
+class FixedStepAnimationDriver : public QAnimationDriver
+{
+public:
+    explicit FixedStepAnimationDriver(qint64 stepMs) : m_step(stepMs) { }
+
+    void advance() override
+    {
+        m_elapsed += m_step;
+        advanceAnimation();
+    }
+
+    qint64 elapsed() const override { return m_elapsed; }
+
+private:
+    qint64 m_step;
+    qint64 m_elapsed = 0;
+};
+
+enum Stage {
+    PolishStage,
+    SyncStage,
+    RenderStage,
+    StageCount
+};
+
+static const char *stageNames[StageCount] = {
+    "polish",
+    "sync",
+    "render"
+};
+
+static QJsonObject stageStatistics(std::vector<qint64> nsecs)
+{
+    QJsonObject result;
+    if (nsecs.empty())
+        return result;
+
+    std::sort(nsecs.begin(), nsecs.end());
+    auto percentile = [&nsecs](double p) {
+        const size_t i = qMin(nsecs.size() - 1, size_t(p * (nsecs.size() - 1) + 0.5));
+        return nsecs[i] / 1000.0;
+    };
+    result.insert(QLatin1String("min_us"), nsecs.front() / 1000.0);
+    result.insert(QLatin1String("median_us"), percentile(0.5));
+    result.insert(QLatin1String("p99_us"), percentile(0.99));
+    return result;
+}
+
+int HeadlessRunner::run()
+{
+#if QT_CONFIG(vulkan)
+    // must outlive the window and the render control, that own the QRhi
+    QVulkanInstance inst;
+    if (QQuickWindow::graphicsApi() == QSGRendererInterface::Vulkan) {
+        inst.setExtensions(QQuickGraphicsConfiguration::preferredInstanceExtensions());
+        if (!inst.create()) {
+            qWarning("Failed to create Vulkan instance");
+            return 1;
+        }
+    }
+#endif
+
+    QQuickRenderControl renderControl;
+    QQuickWindow window(&renderControl);
+    window.setGeometry(0, 0, size.width(), size.height());
+
+#if QT_CONFIG(vulkan)
+    if (inst.isValid())
+        window.setVulkanInstance(&inst);
+#endif
+
+    QQmlEngine engine;
+    QQmlComponent component(&engine, source);
+    if (component.isError()) {
+        qWarning("%s", qPrintable(component.errorString()));
+        return 1;
+    }
+    std::unique_ptr<QObject> rootObject(component.createWithInitialProperties(initialProperties));
+    QQuickItem *rootItem = qobject_cast<QQuickItem *>(rootObject.get());
+    if (!rootItem) {
+        qWarning("%s", qPrintable(component.errorString()));
+        return 1;
+    }
+    rootItem->setParentItem(window.contentItem());
+    window.contentItem()->setSize(size);
+    rootItem->setSize(size);
+
+    if (!renderControl.initialize()) {
+        qWarning("Failed to initialize QQuickRenderControl");
+        return 1;
+    }
+
+    QRhi *rhi = renderControl.rhi();
+    std::unique_ptr<QRhiTexture> tex(rhi->newTexture(QRhiTexture::RGBA8, size, 1,
+                                                     QRhiTexture::RenderTarget | QRhiTexture::UsedAsTransferSource));
+    tex->create();
+    std::unique_ptr<QRhiRenderBuffer> ds(rhi->newRenderBuffer(QRhiRenderBuffer::DepthStencil, size, 1));
+    ds->create();
+    QRhiTextureRenderTargetDescription rtDesc(QRhiColorAttachment(tex.get()));
+    rtDesc.setDepthStencilBuffer(ds.get());
+    std::unique_ptr<QRhiTextureRenderTarget> rt(rhi->newTextureRenderTarget(rtDesc));
+    std::unique_ptr<QRhiRenderPassDescriptor> rp(rt->newCompatibleRenderPassDescriptor());
+    rt->setRenderPassDescriptor(rp.get());
+    rt->create();
+    window.setRenderTarget(QQuickRenderTarget::fromRhiRenderTarget(rt.get()));
+
+    FixedStepAnimationDriver animationDriver(16);
+    animationDriver.install();
+
+    std::vector<qint64> timings[StageCount];
+    for (std::vector<qint64> &t : timings)
+        t.reserve(frameCount);
+
+    QElapsedTimer timer;
+    for (int frame = 0; frame < warmupCount + frameCount; ++frame) {
+        animationDriver.advance();
+
+        timer.start();
+        renderControl.polishItems();
+        const qint64 polishTime = timer.nsecsElapsed();
+
+        renderControl.beginFrame();
+        timer.start();
+        renderControl.sync();
+        const qint64 syncTime = timer.nsecsElapsed();
+
+        // endFrame() submits and, this being an offscreen frame, waits for
+        // the GPU to finish
+        timer.start();
+        renderControl.render();
+        renderControl.endFrame();
+        const qint64 renderTime = timer.nsecsElapsed();
+
+        if (frame >= warmupCount) {
+            timings[PolishStage].push_back(polishTime);
+            timings[SyncStage].push_back(syncTime);
+            timings[RenderStage].push_back(renderTime);
+        }
+    }
+
+    animationDriver.uninstall();
+
+    QJsonObject stages;
+    for (int s = 0; s < StageCount; ++s)
+        stages.insert(QLatin1String(stageNames[s]), stageStatistics(timings[s]));
+
+    QJsonObject result;
+    result.insert(QLatin1String("backend"), QLatin1String(rhi->backendName()));
+    result.insert(QLatin1String("device"), QString::fromUtf8(rhi->driverInfo().deviceName));
+    result.insert(QLatin1String("source"), source.toString());
+    result.insert(QLatin1String("width"), size.width());
+    result.insert(QLatin1String("height"), size.height());
+    result.insert(QLatin1String("frames"), frameCount);
+    result.insert(QLatin1String("stages"), stages);
+    const QByteArray json = QJsonDocument(result).toJson();
+
+    // release the render target before the QRhi goes away with the window
+    window.setRenderTarget(QQuickRenderTarget());
+    rt.reset();
+    rp.reset();
+    ds.reset();
+    tex.reset();
+
+    if (outputFileName.isEmpty()) {
+        fwrite(json.constData(), 1, json.size(), stdout);
+        fflush(stdout);
+    } else {
+        QFile f(outputFileName);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning("Failed to write %s", qPrintable(outputFileName));
+            return 1;
+        }
+        f.write(json);
+    }
+
+    return 0;
+}
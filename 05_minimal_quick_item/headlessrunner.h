@@ -0,0 +1,32 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef HEADLESSRUNNER_H
+#define HEADLESSRUNNER_H
+
+#include <QSize>
+#include <QString>
+#include <QUrl>
+#include <QVariantMap>
+
+// Renders a QML scene with QQuickRenderControl into an offscreen texture,
+// without any on-screen window, for a fixed number of frames, with the
+// animations advanced by exactly 1/60 s per frame, and reports the time
+// spent in polish, sync, and render (which includes waiting for the GPU)
+// for each frame as JSON. Works with QT_QPA_PLATFORM=offscreen, and software
+// rasterizers such as llvmpipe or lavapipe, so it can run in CI.
+class HeadlessRunner
+{
+public:
+    QUrl source;
+    QVariantMap initialProperties;
+    QSize size = QSize(1280, 720);
+    int frameCount = 200;
+    int warmupCount = 20;
+    QString outputFileName; // stdout when empty
+
+    // returns the exit code for main()
+    int run();
+};
+
+#endif
@@ -2,16 +2,175 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QQuickGraphicsConfiguration>
 #include <QQuickView>
+#include <QStandardPaths>
+#include <QTimer>
+#include "headlessrunner.h"
+#include "rhiresourcecache.h"
+
+static QString pipelineCacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QString::asprintf("/pipelinecache_%d.bin", int(QQuickWindow::graphicsApi()));
+}
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame, and if the pipeline cache was used"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption adaptiveResolutionOption("adaptive-resolution", QLatin1String("Scale the RhiItem's resolution based on the GPU frame time"));
+    cmdLineParser.addOption(adaptiveResolutionOption);
+    QCommandLineOption stressOption("stress", QLatin1String("Show a grid of N RhiItems instead"), QLatin1String("N"));
+    cmdLineParser.addOption(stressOption);
+    QCommandLineOption noSharingOption("no-resource-sharing", QLatin1String("Let each RhiItem create its own vertex buffer and pipeline"));
+    cmdLineParser.addOption(noSharingOption);
+    QCommandLineOption frameTimingOption("frame-timing", QLatin1String("Print the average and the longest frame time every second"));
+    cmdLineParser.addOption(frameTimingOption);
+    QCommandLineOption renderThreadAnimationOption("render-thread-animation", QLatin1String("Animate the rotation on the render thread instead of with a NumberAnimation"));
+    cmdLineParser.addOption(renderThreadAnimationOption);
+    QCommandLineOption guiLoadOption("gui-load", QLatin1String("Keep the main thread busy for MS milliseconds at a time, whenever it gets to process events"), QLatin1String("MS"));
+    cmdLineParser.addOption(guiLoadOption);
+    QCommandLineOption headlessOption("headless", QLatin1String("Render with QQuickRenderControl into a texture, without a window, and print polish/sync/render timings as JSON"));
+    cmdLineParser.addOption(headlessOption);
+    QCommandLineOption glOption({ "g", "opengl" }, QLatin1String("With --headless, use OpenGL"));
+    cmdLineParser.addOption(glOption);
+    QCommandLineOption vkOption({ "v", "vulkan" }, QLatin1String("With --headless, use Vulkan"));
+    cmdLineParser.addOption(vkOption);
+    QCommandLineOption sizeOption({ "s", "size" }, QLatin1String("With --headless, the size of the scene (default 1280x720)"), QLatin1String("WxH"), QLatin1String("1280x720"));
+    cmdLineParser.addOption(sizeOption);
+    QCommandLineOption framesOption({ "f", "frames" }, QLatin1String("With --headless, the number of measured frames (default 200)"), QLatin1String("count"), QLatin1String("200"));
+    cmdLineParser.addOption(framesOption);
+    QCommandLineOption warmupOption({ "w", "warmup" }, QLatin1String("With --headless, the number of frames rendered before measuring (default 20)"), QLatin1String("count"), QLatin1String("20"));
+    cmdLineParser.addOption(warmupOption);
+    QCommandLineOption outputOption({ "o", "output" }, QLatin1String("With --headless, write the JSON results to a file instead of stdout"), QLatin1String("file"));
+    cmdLineParser.addOption(outputOption);
+    cmdLineParser.process(app);
+
+    RhiResourceCache::setSharingEnabled(!cmdLineParser.isSet(noSharingOption));
+
+    if (cmdLineParser.isSet(headlessOption)) {
+        if (cmdLineParser.isSet(glOption))
+            QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+        if (cmdLineParser.isSet(vkOption))
+            QQuickWindow::setGraphicsApi(QSGRendererInterface::Vulkan);
+
+        HeadlessRunner runner;
+        const QStringList sizeStr = cmdLineParser.value(sizeOption).split(QLatin1Char('x'));
+        runner.size = sizeStr.count() == 2 ? QSize(sizeStr[0].toInt(), sizeStr[1].toInt()) : QSize();
+        if (runner.size.isEmpty())
+            qFatal("Invalid size %s", qPrintable(cmdLineParser.value(sizeOption)));
+        runner.frameCount = qMax(1, cmdLineParser.value(framesOption).toInt());
+        runner.warmupCount = qMax(0, cmdLineParser.value(warmupOption).toInt());
+        runner.outputFileName = cmdLineParser.value(outputOption);
+        if (cmdLineParser.isSet(stressOption)) {
+            runner.source = QUrl("qrc:///stress.qml");
+            runner.initialProperties.insert(QLatin1String("itemCount"), qMax(1, cmdLineParser.value(stressOption).toInt()));
+        } else {
+            runner.source = QUrl("qrc:///main.qml");
+        }
+        return runner.run();
+    }
+
     QQuickView view;
+
+    // Qt Quick ignores a cache from another device or driver on its own, so
+    // one file per graphics API is enough.
+    const QString pipelineCacheFile = pipelineCacheFileName();
+    const bool pipelineCacheWarm = QFileInfo::exists(pipelineCacheFile);
+    QDir().mkpath(QFileInfo(pipelineCacheFile).absolutePath());
+    QQuickGraphicsConfiguration config;
+    config.setPipelineCacheLoadFile(pipelineCacheFile);
+    config.setPipelineCacheSaveFile(pipelineCacheFile);
+    // needed for QRhiCommandBuffer::lastCompletedGpuTime()
+    if (cmdLineParser.isSet(adaptiveResolutionOption))
+        config.setTimestamps(true);
+    view.setGraphicsConfiguration(config);
+
+    if (cmdLineParser.isSet(reportStartupOption)) {
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [startupTimer, pipelineCacheWarm] {
+            qDebug("Time to first frame: %lld ms (pipeline cache %s)", startupTimer.elapsed(),
+                   pipelineCacheWarm ? "warm" : "cold");
+        }, Qt::SingleShotConnection);
+    }
+
+    // frameSwapped is emitted on the render thread, if there is one. It is
+    // handled there directly, so that a busy main thread (see --gui-load) does
+    // not affect the numbers. The longest frame shows the stutter that the
+    // average hides.
+    struct {
+        QElapsedTimer timer;
+        qint64 lastFrame = 0;
+        qint64 longestFrame = 0;
+        int frameCount = 0;
+    } frameTiming;
+    if (cmdLineParser.isSet(frameTimingOption)) {
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [&frameTiming] {
+            if (!frameTiming.timer.isValid()) {
+                frameTiming.timer.start();
+                return;
+            }
+            const qint64 now = frameTiming.timer.nsecsElapsed();
+            frameTiming.longestFrame = qMax(frameTiming.longestFrame, now - frameTiming.lastFrame);
+            frameTiming.lastFrame = now;
+            ++frameTiming.frameCount;
+            if (now >= 1000000000) {
+                qDebug("%d frames, average frame time %.2f ms, longest %.2f ms", frameTiming.frameCount,
+                       now / 1000000.0 / frameTiming.frameCount, frameTiming.longestFrame / 1000000.0);
+                frameTiming.frameCount = 0;
+                frameTiming.longestFrame = 0;
+                frameTiming.lastFrame = 0;
+                frameTiming.timer.restart();
+            }
+        }, Qt::DirectConnection);
+    }
+
+    // Simulates an application doing heavy work on the main thread. With a
+    // NumberAnimation the triangle only moves when the main thread gets to
+    // advance the animation and synchronize, with --render-thread-animation
+    // it does not depend on the main thread.
+    QTimer guiLoadTimer;
+    if (cmdLineParser.isSet(guiLoadOption)) {
+        const int guiLoadMs = qMax(1, cmdLineParser.value(guiLoadOption).toInt());
+        QObject::connect(&guiLoadTimer, &QTimer::timeout, &guiLoadTimer, [guiLoadMs] {
+            QElapsedTimer busyTimer;
+            busyTimer.start();
+            while (busyTimer.elapsed() < guiLoadMs) { }
+        });
+        guiLoadTimer.start(0);
+    }
+
     view.setResizeMode(QQuickView::SizeRootObjectToView);
-    view.setSource(QUrl("qrc:///main.qml"));
+    QVariantMap initialProperties;
+    if (cmdLineParser.isSet(renderThreadAnimationOption))
+        initialProperties.insert(QLatin1String("renderThreadAnimation"), true);
+    if (cmdLineParser.isSet(stressOption)) {
+        initialProperties.insert(QLatin1String("itemCount"), qMax(1, cmdLineParser.value(stressOption).toInt()));
+        view.setInitialProperties(initialProperties);
+        view.setSource(QUrl("qrc:///stress.qml"));
+    } else {
+        if (cmdLineParser.isSet(adaptiveResolutionOption))
+            initialProperties.insert(QLatin1String("adaptiveResolution"), true);
+        view.setInitialProperties(initialProperties);
+        view.setSource(QUrl("qrc:///main.qml"));
+    }
     view.show();
 
-    return app.exec();
+    const int ret = app.exec();
+
+    if (cmdLineParser.isSet(stressOption) || cmdLineParser.isSet(frameTimingOption) || cmdLineParser.isSet(reportStartupOption))
+        qDebug("Graphics pipelines created for RhiItems: %d", RhiResourceCache::pipelineCreationCount());
+
+    return ret;
 }
@@ -6,9 +6,26 @@ Item {
     width: 1280
     height: 720
 
+    // set from the command line, see --adaptive-resolution
+    property bool adaptiveResolution: false
+    // see --render-thread-animation
+    property bool renderThreadAnimation: false
+
     RhiItem {
+        id: rhiItem
         anchors.fill: parent
-        NumberAnimation on triangleRotation { to: 360; duration: 1500; loops: -1 }
+        NumberAnimation on triangleRotation { to: 360; duration: 1500; loops: -1; running: !rhiItem.renderThreadAnimation }
+        adaptiveResolution: parent.adaptiveResolution
+        renderThreadAnimation: parent.renderThreadAnimation
+        rotationSpeed: 360 / 1.5
+    }
+
+    Text {
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 8
+        visible: rhiItem.adaptiveResolution
+        text: "Scale " + rhiItem.resolutionScale.toFixed(2) + ", GPU " + rhiItem.gpuFrameTime.toFixed(2) + " ms"
     }
 
     Button {
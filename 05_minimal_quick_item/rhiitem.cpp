@@ -2,7 +2,11 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include "rhiitem.h"
+#include <QCoreApplication>
+#include <QDeadlineTimer>
 #include <QFile>
+#include <QQuickWindow>
+#include <cmath>
 
 // RhiItem lives on the main (gui) thread
 
@@ -16,6 +20,146 @@ void RhiItem::setAngle(float a)
     update();
 }
 
+void RhiItem::setRenderThreadAnimation(bool enable)
+{
+    if (m_renderThreadAnimation == enable)
+        return;
+
+    m_renderThreadAnimation = enable;
+    // a monotonic clock that is the same on all threads
+    m_animationStartTime = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+    emit renderThreadAnimationChanged();
+    update();
+}
+
+void RhiItem::setRotationSpeed(float degreesPerSecond)
+{
+    if (m_rotationSpeed == degreesPerSecond)
+        return;
+
+    m_rotationSpeed = degreesPerSecond;
+    emit rotationSpeedChanged();
+    update();
+}
+
+void RhiItem::setRotationFrom(float a)
+{
+    if (m_rotationFrom == a)
+        return;
+
+    m_rotationFrom = a;
+    emit rotationFromChanged();
+    update();
+}
+
+void RhiItem::setRotationTo(float a)
+{
+    if (m_rotationTo == a)
+        return;
+
+    m_rotationTo = a;
+    emit rotationToChanged();
+    update();
+}
+
+void RhiItem::setAdaptiveResolution(bool enable)
+{
+    if (m_adaptiveResolution == enable)
+        return;
+
+    m_adaptiveResolution = enable;
+    emit adaptiveResolutionChanged();
+    m_framesSinceScaleChange = 0;
+    setResolutionScale(enable ? m_maximumScale : 1.0f);
+}
+
+void RhiItem::setTargetGpuTime(float ms)
+{
+    if (m_targetGpuTime == ms)
+        return;
+
+    m_targetGpuTime = ms;
+    emit targetGpuTimeChanged();
+}
+
+void RhiItem::setMinimumResolutionScale(float scale)
+{
+    if (m_minimumScale == scale)
+        return;
+
+    m_minimumScale = scale;
+    emit minimumResolutionScaleChanged();
+    if (m_adaptiveResolution)
+        setResolutionScale(qBound(m_minimumScale, m_scale, m_maximumScale));
+}
+
+void RhiItem::setMaximumResolutionScale(float scale)
+{
+    if (m_maximumScale == scale)
+        return;
+
+    m_maximumScale = scale;
+    emit maximumResolutionScaleChanged();
+    if (m_adaptiveResolution)
+        setResolutionScale(qBound(m_minimumScale, m_scale, m_maximumScale));
+}
+
+void RhiItem::addGpuTimeSample(float ms)
+{
+    // exponential moving average, so that a single slow frame does not
+    // change anything
+    m_gpuFrameTime = m_gpuFrameTime > 0.0f ? m_gpuFrameTime * 0.9f + ms * 0.1f : ms;
+    emit gpuFrameTimeChanged();
+
+    if (!m_adaptiveResolution)
+        return;
+
+    // Hysteresis: there is a band around the target where nothing changes,
+    // and after a change the average needs time to reflect the new size
+    // before it is looked at again.
+    static const int SETTLE_FRAMES = 30;
+    static const float SCALE_STEP = 0.1f;
+    if (++m_framesSinceScaleChange < SETTLE_FRAMES)
+        return;
+
+    if (m_gpuFrameTime > m_targetGpuTime * 1.1f && m_scale > m_minimumScale)
+        setResolutionScale(qMax(m_minimumScale, m_scale - SCALE_STEP));
+    else if (m_gpuFrameTime < m_targetGpuTime * 0.7f && m_scale < m_maximumScale)
+        setResolutionScale(qMin(m_maximumScale, m_scale + SCALE_STEP));
+}
+
+void RhiItem::setResolutionScale(float scale)
+{
+    if (m_scale == scale)
+        return;
+
+    m_scale = scale;
+    m_framesSinceScaleChange = 0;
+    applyResolutionScale();
+    emit resolutionScaleChanged();
+}
+
+void RhiItem::applyResolutionScale()
+{
+    // 0 means following the item size, which is what we want at full scale
+    if (m_scale >= 1.0f) {
+        setFixedColorBufferWidth(0);
+        setFixedColorBufferHeight(0);
+        return;
+    }
+
+    const qreal dpr = window() ? window()->effectiveDevicePixelRatio() : 1.0;
+    setFixedColorBufferWidth(qMax(1, qRound(width() * dpr * m_scale)));
+    setFixedColorBufferHeight(qMax(1, qRound(height() * dpr * m_scale)));
+}
+
+void RhiItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickRhiItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size())
+        applyResolutionScale();
+}
+
 QQuickRhiItemRenderer *RhiItem::createRenderer()
 {
     // Called on the render thread, if there is one.
@@ -32,6 +176,35 @@ void RhiItemRenderer::synchronize(QQuickRhiItem *rhiItem)
     RhiItem *item = static_cast<RhiItem *>(rhiItem);
     if (item->angle() != m_angle)
         m_angle = item->angle();
+
+    // only the parameters, the angle is calculated in render()
+    m_renderThreadAnimation = item->renderThreadAnimation();
+    m_rotationSpeed = item->rotationSpeed();
+    m_rotationFrom = item->rotationFrom();
+    m_rotationTo = item->rotationTo();
+    m_animationStartTime = item->animationStartTime();
+
+    m_item = item;
+    reportGpuTime();
+}
+
+void RhiItemRenderer::reportGpuTime()
+{
+    // The GPU time (requires QQuickGraphicsConfiguration::setTimestamps()) is
+    // of the whole Qt Quick frame, which includes rendering the RhiItem's
+    // texture. It is reported to the item on the main thread, emitting
+    // signals from here would call into QML on the render thread.
+    // When called from render(), the main thread is not blocked and may be
+    // deleting the item, so only the QPointer is copied here, and checked on
+    // the main thread.
+    if (m_lastGpuTime > 0.0) {
+        const float ms = float(m_lastGpuTime * 1000.0);
+        QMetaObject::invokeMethod(qApp, [item = m_item, ms] {
+            if (item)
+                item->addGpuTimeSample(ms);
+        }, Qt::QueuedConnection);
+        m_lastGpuTime = 0.0;
+    }
 }
 
 void RhiItemRenderer::initialize(QRhiCommandBuffer *cb)
@@ -43,25 +216,19 @@ void RhiItemRenderer::initialize(QRhiCommandBuffer *cb)
 
     if (m_rhi != rhi()) {
         m_rhi = rhi();
-        m_pipeline.reset();
+        m_srb.reset();
+        m_cache = RhiResourceCache::get(m_rhi);
     }
 
-    // In advanced cases one would here check renderTarget()->sampleCount() and
-    // color/resolveTexture()->format() to see if they have changed since the
-    // last invocation of this function, and reinitialize relevant resources
-    // (e.g. the graphics pipeline) if so, but that's not relevant in this
-    // example. Here we'll create our pipeline once and that's it.
-
-    if (!m_pipeline) {
-        static float vertexData[] = { // Y up, CCW
-            0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
-            -0.5f, -0.5f,     0.0f, 1.0f, 0.0f,
-            0.5f,  -0.5f,     0.0f, 0.0f, 1.0f,
-        };
-
-        m_vbuf.reset(m_rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(vertexData)));
-        m_vbuf->create();
+    // The pipeline comes from the cache, based on the render pass
+    // descriptor's format, so asking again each time is cheap, and picks up
+    // changes in e.g. the sample count or the texture format.
+    QRhiResourceUpdateBatch *resourceUpdates = m_rhi->nextResourceUpdateBatch();
+    m_vbuf = m_cache->vertexBuffer(resourceUpdates);
+    m_pipeline = m_cache->pipeline(renderTarget()->renderPassDescriptor());
+    cb->resourceUpdate(resourceUpdates);
 
+    if (!m_srb) {
         m_ubuf.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64));
         m_ubuf->create();
 
@@ -70,32 +237,6 @@ void RhiItemRenderer::initialize(QRhiCommandBuffer *cb)
             QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, m_ubuf.get()),
         });
         m_srb->create();
-
-        m_pipeline.reset(m_rhi->newGraphicsPipeline());
-        static auto getShader = [](const QString &name) {
-            QFile f(name);
-            return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
-        };
-        m_pipeline->setShaderStages({
-            { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color.vert.qsb")) },
-            { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
-        });
-        QRhiVertexInputLayout inputLayout;
-        inputLayout.setBindings({
-            { 5 * sizeof(float) }
-        });
-        inputLayout.setAttributes({
-            { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
-            { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) }
-        });
-        m_pipeline->setVertexInputLayout(inputLayout);
-        m_pipeline->setShaderResourceBindings(m_srb.get());
-        m_pipeline->setRenderPassDescriptor(renderTarget()->renderPassDescriptor());
-        m_pipeline->create();
-
-        QRhiResourceUpdateBatch *resourceUpdates = m_rhi->nextResourceUpdateBatch();
-        resourceUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
-        cb->resourceUpdate(resourceUpdates);
     }
 
     const QSize outputSizeInPixels = renderTarget()->pixelSize();
@@ -108,9 +249,17 @@ void RhiItemRenderer::render(QRhiCommandBuffer *cb)
 {
     // Called on the render thread, if there is one.
 
+    float angle = m_angle;
+    if (m_renderThreadAnimation) {
+        const qint64 now = QDeadlineTimer::current(Qt::PreciseTimer).deadlineNSecs();
+        const float range = m_rotationTo - m_rotationFrom;
+        const double elapsed = (now - m_animationStartTime) / 1000000000.0;
+        angle = m_rotationFrom + (range != 0.0f ? float(std::fmod(elapsed * m_rotationSpeed, double(range))) : 0.0f);
+    }
+
     QRhiResourceUpdateBatch *resourceUpdates = m_rhi->nextResourceUpdateBatch();
     QMatrix4x4 modelViewProjection = m_viewProjection;
-    modelViewProjection.rotate(m_angle, 0, 1, 0);
+    modelViewProjection.rotate(angle, 0, 1, 0);
     resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, modelViewProjection.constData());
 
     // Qt Quick expects premultiplied alpha, not that it matters in this example
@@ -121,12 +270,24 @@ void RhiItemRenderer::render(QRhiCommandBuffer *cb)
 
     cb->beginPass(renderTarget(), clearColor, { 1.0f, 0 }, resourceUpdates);
 
-    cb->setGraphicsPipeline(m_pipeline.get());
+    cb->setGraphicsPipeline(m_pipeline);
     cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
     cb->setShaderResources();
-    const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf.get(), 0);
+    const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf, 0);
     cb->setVertexInput(0, 1, &vbufBinding);
     cb->draw(3);
 
     cb->endPass();
+
+    // for a frame that completed earlier, 0 if not available
+    m_lastGpuTime = cb->lastCompletedGpuTime();
+
+    // Schedules another render() without going through the main thread, no
+    // polish and synchronize, unlike the item's update(). Throttled to the
+    // presentation rate, like any other frame. As synchronize() is skipped
+    // for these frames, the GPU time is reported from here.
+    if (m_renderThreadAnimation) {
+        reportGpuTime();
+        update();
+    }
 }
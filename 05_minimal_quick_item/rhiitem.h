@@ -5,7 +5,9 @@
 #define RHIITEM_H
 
 #include <QQuickRhiItem>
+#include <QPointer>
 #include <rhi/qrhi.h>
+#include "rhiresourcecache.h"
 
 class RhiItemRenderer;
 
@@ -14,6 +16,18 @@ class RhiItem : public QQuickRhiItem
     Q_OBJECT
     QML_ELEMENT
     Q_PROPERTY(float triangleRotation READ angle WRITE setAngle NOTIFY angleChanged)
+    // dynamic resolution, see setAdaptiveResolution()
+    Q_PROPERTY(bool adaptiveResolution READ adaptiveResolution WRITE setAdaptiveResolution NOTIFY adaptiveResolutionChanged)
+    Q_PROPERTY(float targetGpuTime READ targetGpuTime WRITE setTargetGpuTime NOTIFY targetGpuTimeChanged)
+    Q_PROPERTY(float minimumResolutionScale READ minimumResolutionScale WRITE setMinimumResolutionScale NOTIFY minimumResolutionScaleChanged)
+    Q_PROPERTY(float maximumResolutionScale READ maximumResolutionScale WRITE setMaximumResolutionScale NOTIFY maximumResolutionScaleChanged)
+    Q_PROPERTY(float resolutionScale READ resolutionScale NOTIFY resolutionScaleChanged)
+    Q_PROPERTY(float gpuFrameTime READ gpuFrameTime NOTIFY gpuFrameTimeChanged)
+    // rotation animated on the render thread, see setRenderThreadAnimation()
+    Q_PROPERTY(bool renderThreadAnimation READ renderThreadAnimation WRITE setRenderThreadAnimation NOTIFY renderThreadAnimationChanged)
+    Q_PROPERTY(float rotationSpeed READ rotationSpeed WRITE setRotationSpeed NOTIFY rotationSpeedChanged)
+    Q_PROPERTY(float rotationFrom READ rotationFrom WRITE setRotationFrom NOTIFY rotationFromChanged)
+    Q_PROPERTY(float rotationTo READ rotationTo WRITE setRotationTo NOTIFY rotationToChanged)
 
 public:
     QQuickRhiItemRenderer *createRenderer() override;
@@ -21,11 +35,75 @@ public:
     float angle() const { return m_angle; }
     void setAngle(float a);
 
+    // When enabled, the size of the texture the renderer renders into is
+    // scaled down (via fixedColorBufferWidth/Height, Qt Quick then scales it
+    // up when compositing) while the GPU frame time is above targetGpuTime,
+    // and back up when well below it.
+    bool adaptiveResolution() const { return m_adaptiveResolution; }
+    void setAdaptiveResolution(bool enable);
+    float targetGpuTime() const { return m_targetGpuTime; }
+    void setTargetGpuTime(float ms);
+    float minimumResolutionScale() const { return m_minimumScale; }
+    void setMinimumResolutionScale(float scale);
+    float maximumResolutionScale() const { return m_maximumScale; }
+    void setMaximumResolutionScale(float scale);
+    float resolutionScale() const { return m_scale; }
+    float gpuFrameTime() const { return m_gpuFrameTime; }
+
+    void addGpuTimeSample(float ms);
+
+    // When enabled, triangleRotation is ignored, and the renderer calculates
+    // the rotation itself for each frame, based on the time elapsed since
+    // enabling, looping from rotationFrom to rotationTo with rotationSpeed
+    // degrees per second. New frames are requested from the render thread,
+    // so the animation does not involve the main thread (and QML) at all, and
+    // stays smooth even when the main thread is busy. (with the threaded
+    // render loop, that is)
+    bool renderThreadAnimation() const { return m_renderThreadAnimation; }
+    void setRenderThreadAnimation(bool enable);
+    float rotationSpeed() const { return m_rotationSpeed; }
+    void setRotationSpeed(float degreesPerSecond);
+    float rotationFrom() const { return m_rotationFrom; }
+    void setRotationFrom(float a);
+    float rotationTo() const { return m_rotationTo; }
+    void setRotationTo(float a);
+    qint64 animationStartTime() const { return m_animationStartTime; }
+
 signals:
     void angleChanged();
+    void adaptiveResolutionChanged();
+    void targetGpuTimeChanged();
+    void minimumResolutionScaleChanged();
+    void maximumResolutionScaleChanged();
+    void resolutionScaleChanged();
+    void gpuFrameTimeChanged();
+    void renderThreadAnimationChanged();
+    void rotationSpeedChanged();
+    void rotationFromChanged();
+    void rotationToChanged();
+
+protected:
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
 
 private:
+    void setResolutionScale(float scale);
+    void applyResolutionScale();
+
     float m_angle = 0.0f;
+
+    bool m_adaptiveResolution = false;
+    float m_targetGpuTime = 8.0f;
+    float m_minimumScale = 0.25f;
+    float m_maximumScale = 1.0f;
+    float m_scale = 1.0f;
+    float m_gpuFrameTime = 0.0f;
+    int m_framesSinceScaleChange = 0;
+
+    bool m_renderThreadAnimation = false;
+    float m_rotationSpeed = 240.0f;
+    float m_rotationFrom = 0.0f;
+    float m_rotationTo = 360.0f;
+    qint64 m_animationStartTime = 0;
 };
 
 class RhiItemRenderer : public QQuickRhiItemRenderer
@@ -36,15 +114,29 @@ public:
     void render(QRhiCommandBuffer *cb) override;
 
 private:
+    void reportGpuTime();
+
     QRhi *m_rhi = nullptr;
+    // set in synchronize(), only dereferenced on the main thread
+    QPointer<RhiItem> m_item;
 
-    std::unique_ptr<QRhiBuffer> m_vbuf;
+    // the vertex buffer and the pipeline are owned by the cache, shared with
+    // the other RhiItems
+    std::shared_ptr<RhiResourceCache> m_cache;
+    QRhiBuffer *m_vbuf = nullptr;
+    QRhiGraphicsPipeline *m_pipeline = nullptr;
     std::unique_ptr<QRhiBuffer> m_ubuf;
     std::unique_ptr<QRhiShaderResourceBindings> m_srb;
-    std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
 
     QMatrix4x4 m_viewProjection;
     float m_angle = 0.0f;
+    double m_lastGpuTime = 0.0;
+
+    bool m_renderThreadAnimation = false;
+    float m_rotationSpeed = 0.0f;
+    float m_rotationFrom = 0.0f;
+    float m_rotationTo = 0.0f;
+    qint64 m_animationStartTime = 0;
 };
 
 #endif
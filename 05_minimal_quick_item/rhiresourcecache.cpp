@@ -0,0 +1,142 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "rhiresourcecache.h"
+#include <QAtomicInt>
+#include <QFile>
+
+// With the threaded render loop there is a render thread per window, so this
+// may be accessed from multiple threads.
+Q_GLOBAL_STATIC(QMutex, cacheMutex)
+Q_GLOBAL_STATIC((QHash<QRhi *, std::weak_ptr<RhiResourceCache>>), caches)
+static bool sharingEnabled = true;
+static QAtomicInt pipelineCount;
+
+RhiResourceCache::RhiResourceCache(QRhi *rhi)
+    : m_rhi(rhi)
+{
+    m_rhi->addCleanupCallback(this, [this](QRhi *rhi) {
+        // the QRhi is being destroyed while renderers still refer to us
+        QMutexLocker lock(cacheMutex());
+        auto it = caches()->find(rhi);
+        if (it != caches()->end() && it->lock().get() == this)
+            caches()->erase(it);
+        lock.unlock();
+        releaseResources();
+        m_rhi = nullptr;
+    });
+}
+
+RhiResourceCache::~RhiResourceCache()
+{
+    if (!m_rhi)
+        return;
+
+    QMutexLocker lock(cacheMutex());
+    auto it = caches()->find(m_rhi);
+    if (it != caches()->end() && it->expired())
+        caches()->erase(it);
+    lock.unlock();
+
+    m_rhi->removeCleanupCallback(this);
+    releaseResources();
+}
+
+std::shared_ptr<RhiResourceCache> RhiResourceCache::get(QRhi *rhi)
+{
+    QMutexLocker lock(cacheMutex());
+    if (!sharingEnabled)
+        return std::make_shared<RhiResourceCache>(rhi);
+
+    std::weak_ptr<RhiResourceCache> &entry((*caches())[rhi]);
+    std::shared_ptr<RhiResourceCache> cache = entry.lock();
+    if (!cache) {
+        cache = std::make_shared<RhiResourceCache>(rhi);
+        entry = cache;
+    }
+    return cache;
+}
+
+void RhiResourceCache::setSharingEnabled(bool enable)
+{
+    QMutexLocker lock(cacheMutex());
+    sharingEnabled = enable;
+}
+
+int RhiResourceCache::pipelineCreationCount()
+{
+    return pipelineCount.loadRelaxed();
+}
+
+void RhiResourceCache::releaseResources()
+{
+    qDeleteAll(m_pipelines);
+    m_pipelines.clear();
+    qDeleteAll(m_renderPasses);
+    m_renderPasses.clear();
+    m_layoutSrb.reset();
+    m_layoutUbuf.reset();
+    m_vbuf.reset();
+}
+
+QRhiBuffer *RhiResourceCache::vertexBuffer(QRhiResourceUpdateBatch *resourceUpdates)
+{
+    if (!m_vbuf) {
+        static float vertexData[] = { // Y up, CCW
+            0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
+            -0.5f, -0.5f,     0.0f, 1.0f, 0.0f,
+            0.5f,  -0.5f,     0.0f, 0.0f, 1.0f,
+        };
+
+        m_vbuf.reset(m_rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(vertexData)));
+        m_vbuf->create();
+        resourceUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
+    }
+    return m_vbuf.get();
+}
+
+QRhiGraphicsPipeline *RhiResourceCache::pipeline(QRhiRenderPassDescriptor *rp)
+{
+    // Render pass descriptors with the same format are compatible, even when
+    // they are different objects, e.g. because they belong to different items.
+    const QVector<quint32> format = rp->serializedFormat();
+    QRhiGraphicsPipeline *&ps(m_pipelines[format]);
+    if (ps)
+        return ps;
+
+    if (!m_layoutSrb) {
+        m_layoutUbuf.reset(m_rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64));
+        m_layoutUbuf->create();
+        m_layoutSrb.reset(m_rhi->newShaderResourceBindings());
+        m_layoutSrb->setBindings({
+            QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, m_layoutUbuf.get()),
+        });
+        m_layoutSrb->create();
+    }
+
+    ps = m_rhi->newGraphicsPipeline();
+    static auto getShader = [](const QString &name) {
+        QFile f(name);
+        return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+    };
+    ps->setShaderStages({
+        { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color.vert.qsb")) },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color.frag.qsb")) }
+    });
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { 5 * sizeof(float) }
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+        { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) }
+    });
+    ps->setVertexInputLayout(inputLayout);
+    ps->setShaderResourceBindings(m_layoutSrb.get());
+    QRhiRenderPassDescriptor *ownRp = rp->newCompatibleRenderPassDescriptor();
+    m_renderPasses.insert(format, ownRp);
+    ps->setRenderPassDescriptor(ownRp);
+    ps->create();
+    pipelineCount.ref();
+    return ps;
+}
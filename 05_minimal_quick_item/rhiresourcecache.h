@@ -0,0 +1,54 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef RHIRESOURCECACHE_H
+#define RHIRESOURCECACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <rhi/qrhi.h>
+#include <memory>
+
+// The resources that are the same for all RhiItems: the vertex buffer, and
+// the graphics pipelines, one per render pass descriptor format. With many
+// items, this avoids creating (compiling) the same pipeline and uploading the
+// same geometry again and again. The uniform buffer and the srb stay per item.
+//
+// Renderers get the cache for their QRhi from get(), and hold on to the
+// shared_ptr while they use its resources. The last one going away (e.g.
+// because the scenegraph is invalidated) releases everything. Should the QRhi
+// go away before that, the resources are released at that point.
+class RhiResourceCache
+{
+public:
+    explicit RhiResourceCache(QRhi *rhi);
+    ~RhiResourceCache();
+
+    static std::shared_ptr<RhiResourceCache> get(QRhi *rhi);
+
+    // When disabled, get() returns a new cache each time, so every renderer
+    // creates its own resources, for comparison.
+    static void setSharingEnabled(bool enable);
+
+    // The upload, if needed, is added to resourceUpdates.
+    QRhiBuffer *vertexBuffer(QRhiResourceUpdateBatch *resourceUpdates);
+    QRhiGraphicsPipeline *pipeline(QRhiRenderPassDescriptor *rp);
+
+    static int pipelineCreationCount();
+
+private:
+    void releaseResources();
+
+    QRhi *m_rhi;
+    std::unique_ptr<QRhiBuffer> m_vbuf;
+    // only for describing the layout to the pipelines
+    std::unique_ptr<QRhiBuffer> m_layoutUbuf;
+    std::unique_ptr<QRhiShaderResourceBindings> m_layoutSrb;
+    QHash<QVector<quint32>, QRhiGraphicsPipeline *> m_pipelines;
+    // Owned, compatible render pass descriptors for the pipelines, by the same
+    // key. The ones passed to pipeline() belong to the items' render targets,
+    // and are gone on resize or with the item.
+    QHash<QVector<quint32>, QRhiRenderPassDescriptor *> m_renderPasses;
+};
+
+#endif
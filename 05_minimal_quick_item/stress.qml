@@ -0,0 +1,30 @@
+import QtQuick
+import TestApp
+
+// Many RhiItems, see --stress
+Item {
+    id: root
+    width: 1280
+    height: 720
+
+    property int itemCount: 200
+    property bool renderThreadAnimation: false
+    readonly property int columns: Math.ceil(Math.sqrt(itemCount * width / height))
+
+    Grid {
+        anchors.fill: parent
+        columns: root.columns
+        Repeater {
+            model: root.itemCount
+            RhiItem {
+                width: root.width / root.columns
+                height: width
+                NumberAnimation on triangleRotation { from: index * 7; to: index * 7 + 360; duration: 1500; loops: -1; running: !root.renderThreadAnimation }
+                renderThreadAnimation: root.renderThreadAnimation
+                rotationFrom: index * 7
+                rotationTo: index * 7 + 360
+                rotationSpeed: 360 / 1.5
+            }
+        }
+    }
+}
@@ -0,0 +1,15 @@
+#version 440
+
+layout(location = 0) in vec3 v_color;
+layout(location = 1) in vec2 v_ndc;
+layout(location = 2) in vec4 v_clipRect;
+
+layout(location = 0) out vec4 fragColor;
+
+void main()
+{
+    // what the scissor would do with the per-node path
+    if (any(lessThan(v_ndc, v_clipRect.xy)) || any(greaterThan(v_ndc, v_clipRect.zw)))
+        discard;
+    fragColor = vec4(v_color, 1.0);
+}
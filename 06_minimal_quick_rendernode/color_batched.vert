@@ -0,0 +1,30 @@
+#version 440
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec3 color;
+// per instance
+layout(location = 2) in vec4 mvpCol0;
+layout(location = 3) in vec4 mvpCol1;
+layout(location = 4) in vec4 mvpCol2;
+layout(location = 5) in vec4 mvpCol3;
+layout(location = 6) in vec4 itemRect; // center, half size, in NDC (Y up)
+layout(location = 7) in vec4 clipRect; // min, max, in NDC (Y up)
+
+layout(location = 0) out vec3 v_color;
+layout(location = 1) out vec2 v_ndc;
+layout(location = 2) out vec4 v_clipRect;
+
+layout(std140, binding = 0) uniform buf {
+    mat4 clipSpaceCorr;
+};
+
+void main()
+{
+    v_color = color;
+    v_clipRect = clipRect;
+    // what the viewport would do with the per-node path: map the item's own
+    // [-1, 1] range to the item's rectangle
+    vec4 p = mat4(mvpCol0, mvpCol1, mvpCol2, mvpCol3) * position;
+    v_ndc = itemRect.xy + p.xy / p.w * itemRect.zw;
+    gl_Position = clipSpaceCorr * vec4(v_ndc, p.z / p.w, 1.0);
+}
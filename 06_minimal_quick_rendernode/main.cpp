@@ -2,15 +2,104 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QQuickGraphicsConfiguration>
 #include <QQuickView>
+#include <QStandardPaths>
+#include "rhirendernode.h"
+
+static QString pipelineCacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+        + QString::asprintf("/pipelinecache_%d.bin", int(QQuickWindow::graphicsApi()));
+}
 
 int main(int argc, char **argv)
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
+    QCommandLineParser cmdLineParser;
+    cmdLineParser.addHelpOption();
+    QCommandLineOption reportStartupOption("report-startup", QLatin1String("Print the time to the first frame, and if the pipeline cache was used"));
+    cmdLineParser.addOption(reportStartupOption);
+    QCommandLineOption batchedOption("batched", QLatin1String("Draw all RhiItems in the window with one instanced draw call"));
+    cmdLineParser.addOption(batchedOption);
+    QCommandLineOption stressOption("stress", QLatin1String("Show a grid of N RhiItems instead"), QLatin1String("N"));
+    cmdLineParser.addOption(stressOption);
+    QCommandLineOption frameTimingOption("frame-timing", QLatin1String("Print the average frame time and the time spent in rendering the scene on the render thread every second"));
+    cmdLineParser.addOption(frameTimingOption);
+    cmdLineParser.process(app);
+
+    RhiRenderNode::setBatchingEnabled(cmdLineParser.isSet(batchedOption));
+
     QQuickView view;
+
+    // loaded when the scenegraph initializes, saved when it is released
+    const QString pipelineCacheFile = pipelineCacheFileName();
+    const bool pipelineCacheWarm = QFileInfo::exists(pipelineCacheFile);
+    QDir().mkpath(QFileInfo(pipelineCacheFile).absolutePath());
+    QQuickGraphicsConfiguration config;
+    config.setPipelineCacheLoadFile(pipelineCacheFile);
+    config.setPipelineCacheSaveFile(pipelineCacheFile);
+    view.setGraphicsConfiguration(config);
+
+    if (cmdLineParser.isSet(reportStartupOption)) {
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [startupTimer, pipelineCacheWarm] {
+            qDebug("Time to first frame: %lld ms (pipeline cache %s)", startupTimer.elapsed(),
+                   pipelineCacheWarm ? "warm" : "cold");
+        }, Qt::SingleShotConnection);
+    }
+
+    // Everything here happens on the render thread, if there is one. The
+    // render time is the CPU time from the start of preparing the frame to the
+    // end of recording the render pass (which includes all the prepare() and
+    // render() calls), so that is what differs between the per-node and
+    // batched paths. With vsync, the frame time will mostly stay the same.
+    struct {
+        QElapsedTimer frameTimer;
+        QElapsedTimer renderTimer;
+        qint64 renderTime = 0;
+        int frameCount = 0;
+    } frameTiming;
+    if (cmdLineParser.isSet(frameTimingOption)) {
+        QObject::connect(&view, &QQuickWindow::beforeRendering, &view, [&frameTiming] {
+            frameTiming.renderTimer.start();
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::afterRenderPassRecording, &view, [&frameTiming] {
+            frameTiming.renderTime += frameTiming.renderTimer.nsecsElapsed();
+        }, Qt::DirectConnection);
+        QObject::connect(&view, &QQuickWindow::frameSwapped, &view, [&frameTiming] {
+            if (!frameTiming.frameTimer.isValid()) {
+                frameTiming.frameTimer.start();
+                frameTiming.renderTime = 0;
+                return;
+            }
+            ++frameTiming.frameCount;
+            if (frameTiming.frameTimer.elapsed() >= 1000) {
+                qDebug("%d frames, average frame time %.2f ms, render %.3f ms",
+                       frameTiming.frameCount,
+                       frameTiming.frameTimer.nsecsElapsed() / 1000000.0 / frameTiming.frameCount,
+                       frameTiming.renderTime / 1000000.0 / frameTiming.frameCount);
+                frameTiming.frameCount = 0;
+                frameTiming.renderTime = 0;
+                frameTiming.frameTimer.restart();
+            }
+        }, Qt::DirectConnection);
+    }
+
     view.setResizeMode(QQuickView::SizeRootObjectToView);
-    view.setSource(QUrl("qrc:///main.qml"));
+    if (cmdLineParser.isSet(stressOption)) {
+        view.setInitialProperties({ { QLatin1String("itemCount"), qMax(1, cmdLineParser.value(stressOption).toInt()) } });
+        view.setSource(QUrl("qrc:///stress.qml"));
+    } else {
+        view.setSource(QUrl("qrc:///main.qml"));
+    }
     view.show();
 
     return app.exec();
@@ -0,0 +1,139 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#include "rendernodebatch.h"
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QQuickWindow>
+
+// With the threaded render loop there is a render thread per window, so this
+// may be accessed from multiple threads.
+Q_GLOBAL_STATIC(QMutex, batchMutex)
+Q_GLOBAL_STATIC((QHash<QQuickWindow *, std::weak_ptr<RenderNodeBatch>>), batches)
+
+RenderNodeBatch::~RenderNodeBatch()
+{
+    QMutexLocker lock(batchMutex());
+    for (auto it = batches()->begin(); it != batches()->end(); ) {
+        if (it->expired())
+            it = batches()->erase(it);
+        else
+            ++it;
+    }
+}
+
+std::shared_ptr<RenderNodeBatch> RenderNodeBatch::get(QQuickWindow *window)
+{
+    QMutexLocker lock(batchMutex());
+    std::weak_ptr<RenderNodeBatch> &entry((*batches())[window]);
+    std::shared_ptr<RenderNodeBatch> batch = entry.lock();
+    if (!batch) {
+        batch = std::make_shared<RenderNodeBatch>();
+        entry = batch;
+    }
+    return batch;
+}
+
+void RenderNodeBatch::createPipeline(QRhi *rhi, QRhiRenderPassDescriptor *rp, QRhiResourceUpdateBatch *resourceUpdates)
+{
+    static float vertexData[] = { // Y up, CCW
+        0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
+        -0.5f, -0.5f,     0.0f, 1.0f, 0.0f,
+        0.5f,  -0.5f,     0.0f, 0.0f, 1.0f,
+    };
+
+    m_vbuf.reset(rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(vertexData)));
+    m_vbuf->create();
+    resourceUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
+
+    // the per-instance matrices are calculated without it, the shader
+    // applies it after mapping to the item's rectangle
+    m_ubuf.reset(rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::UniformBuffer, 64));
+    m_ubuf->create();
+    resourceUpdates->uploadStaticBuffer(m_ubuf.get(), rhi->clipSpaceCorrMatrix().constData());
+
+    m_srb.reset(rhi->newShaderResourceBindings());
+    m_srb->setBindings({
+        QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage, m_ubuf.get()),
+    });
+    m_srb->create();
+
+    m_pipeline.reset(rhi->newGraphicsPipeline());
+    m_pipeline->setDepthTest(true); // like the per-node pipeline
+    static auto getShader = [](const QString &name) {
+        QFile f(name);
+        return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
+    };
+    m_pipeline->setShaderStages({
+        { QRhiShaderStage::Vertex, getShader(QLatin1String(":/shaders/color_batched.vert.qsb")) },
+        { QRhiShaderStage::Fragment, getShader(QLatin1String(":/shaders/color_batched.frag.qsb")) }
+    });
+    QRhiVertexInputLayout inputLayout;
+    inputLayout.setBindings({
+        { 5 * sizeof(float) },
+        { INSTANCE_FLOATS * sizeof(float), QRhiVertexInputBinding::PerInstance }
+    });
+    inputLayout.setAttributes({
+        { 0, 0, QRhiVertexInputAttribute::Float2, 0 },
+        { 0, 1, QRhiVertexInputAttribute::Float3, 2 * sizeof(float) },
+        { 1, 2, QRhiVertexInputAttribute::Float4, 0 },                  // matrix
+        { 1, 3, QRhiVertexInputAttribute::Float4, 4 * sizeof(float) },
+        { 1, 4, QRhiVertexInputAttribute::Float4, 8 * sizeof(float) },
+        { 1, 5, QRhiVertexInputAttribute::Float4, 12 * sizeof(float) },
+        { 1, 6, QRhiVertexInputAttribute::Float4, 16 * sizeof(float) }, // item rectangle
+        { 1, 7, QRhiVertexInputAttribute::Float4, 20 * sizeof(float) }  // clip rectangle
+    });
+    m_pipeline->setVertexInputLayout(inputLayout);
+    m_pipeline->setShaderResourceBindings(m_srb.get());
+    m_pipeline->setRenderPassDescriptor(rp);
+    m_pipeline->create();
+}
+
+void RenderNodeBatch::addInstance(QRhi *rhi, QRhiRenderPassDescriptor *rp, QRhiResourceUpdateBatch *resourceUpdates, const float *instance)
+{
+    if (!m_pipeline)
+        createPipeline(rhi, rp, resourceUpdates);
+
+    // all prepare()s come before all render()s in a frame, so the first one
+    // after a draw starts a new frame
+    if (m_drawn) {
+        m_instanceCount = 0;
+        m_drawn = false;
+    }
+
+    const int stride = INSTANCE_FLOATS * sizeof(float);
+    m_instances.resize(size_t(m_instanceCount + 1) * INSTANCE_FLOATS);
+    memcpy(m_instances.data() + size_t(m_instanceCount) * INSTANCE_FLOATS, instance, stride);
+    ++m_instanceCount;
+
+    if (m_instanceCount > m_capacity) {
+        // The old buffer may still be in use by frames in flight, QRhi defers
+        // the actual release as appropriate. The instances added earlier in
+        // this frame need to go to the new one as well.
+        m_capacity = qMax(64, m_capacity * 2);
+        m_instanceBuf.reset(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::VertexBuffer, m_capacity * stride));
+        m_instanceBuf->create();
+        resourceUpdates->updateDynamicBuffer(m_instanceBuf.get(), 0, m_instanceCount * stride, m_instances.data());
+    } else {
+        resourceUpdates->updateDynamicBuffer(m_instanceBuf.get(), (m_instanceCount - 1) * stride, stride, instance);
+    }
+}
+
+void RenderNodeBatch::render(QRhiCommandBuffer *cb, const QSize &outputSizeInPixels)
+{
+    if (m_drawn || m_instanceCount == 0)
+        return;
+
+    m_drawn = true;
+
+    cb->setGraphicsPipeline(m_pipeline.get());
+    cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+    cb->setShaderResources();
+    const QRhiCommandBuffer::VertexInput vbufBindings[] = {
+        { m_vbuf.get(), 0 },
+        { m_instanceBuf.get(), 0 }
+    };
+    cb->setVertexInput(0, 2, vbufBindings);
+    cb->draw(3, m_instanceCount);
+}
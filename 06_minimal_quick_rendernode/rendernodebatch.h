@@ -0,0 +1,48 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+#ifndef RENDERNODEBATCH_H
+#define RENDERNODEBATCH_H
+
+#include <rhi/qrhi.h>
+#include <memory>
+#include <vector>
+
+class QQuickWindow;
+
+// Draws the triangles of all RhiRenderNodes in a window with one pipeline and
+// a single instanced draw call. Each node adds its instance in prepare(), and
+// the first node's render() in the frame draws everything, so the triangles
+// all end up at that node's position in the stacking order. (which is fine
+// as long as there is nothing between the items, otherwise the per-node path
+// is needed)
+class RenderNodeBatch
+{
+public:
+    ~RenderNodeBatch();
+
+    static std::shared_ptr<RenderNodeBatch> get(QQuickWindow *window);
+
+    // 4x4 matrix (without clipSpaceCorrMatrix()), the item's rectangle as
+    // center and half size, the clip rectangle as min and max, both in
+    // normalized device coordinates with Y up
+    static const int INSTANCE_FLOATS = 16 + 4 + 4;
+
+    void addInstance(QRhi *rhi, QRhiRenderPassDescriptor *rp, QRhiResourceUpdateBatch *resourceUpdates, const float *instance);
+    void render(QRhiCommandBuffer *cb, const QSize &outputSizeInPixels);
+
+private:
+    void createPipeline(QRhi *rhi, QRhiRenderPassDescriptor *rp, QRhiResourceUpdateBatch *resourceUpdates);
+
+    std::unique_ptr<QRhiBuffer> m_vbuf;
+    std::unique_ptr<QRhiBuffer> m_ubuf;
+    std::unique_ptr<QRhiBuffer> m_instanceBuf;
+    std::unique_ptr<QRhiShaderResourceBindings> m_srb;
+    std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
+    std::vector<float> m_instances;
+    int m_instanceCount = 0;
+    int m_capacity = 0;
+    bool m_drawn = true;
+};
+
+#endif
@@ -2,9 +2,12 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
 
 #include "rhirendernode.h"
+#include "rendernodebatch.h"
 #include <QQuickWindow>
 #include <QFile>
 
+static bool batchingEnabled = false;
+
 // RhiItem lives on the main (gui) thread
 
 RhiItem::RhiItem(QQuickItem *parent)
@@ -35,14 +38,32 @@ QSGNode *RhiItem::updatePaintNode(QSGNode *old, UpdatePaintNodeData *)
     }
 
     node->m_angle = m_angle;
+    node->m_size = size();
 
     return node;
 }
 
 // RhiRenderNode lives on the render thread
 
+RhiRenderNode::RhiRenderNode(QQuickWindow *window)
+    : m_window(window),
+      m_batched(batchingEnabled && window->rhi()->isFeatureSupported(QRhi::Instancing))
+{
+}
+
+void RhiRenderNode::setBatchingEnabled(bool enable)
+{
+    batchingEnabled = enable;
+}
+
+bool RhiRenderNode::isBatchingEnabled()
+{
+    return batchingEnabled;
+}
+
 void RhiRenderNode::releaseResources()
 {
+    m_batch.reset();
     m_vbuf.reset();
     m_ubuf.reset();
     m_srb.reset();
@@ -51,12 +72,40 @@ void RhiRenderNode::releaseResources()
 
 QSGRenderNode::RenderingFlags RhiRenderNode::flags() const
 {
-    return QSGRenderNode::NoExternalRendering;
+    // the batched draw covers all the items in the window, not just this one
+    if (m_batched)
+        return QSGRenderNode::NoExternalRendering;
+
+    return QSGRenderNode::NoExternalRendering | QSGRenderNode::BoundedRectRendering;
 }
 
 QSGRenderNode::StateFlags RhiRenderNode::changedStates() const
 {
-    return QSGRenderNode::StateFlag::ViewportState | QSGRenderNode::StateFlag::CullState;
+    return QSGRenderNode::StateFlag::ViewportState | QSGRenderNode::StateFlag::ScissorState
+        | QSGRenderNode::StateFlag::CullState;
+}
+
+QRectF RhiRenderNode::rect() const
+{
+    return QRectF(QPointF(0, 0), m_size);
+}
+
+// Returns the rectangle in normalized device coordinates, Y up, like in OpenGL
+// regardless of the 3D API. (projectionMatrix() has clipSpaceCorrMatrix()
+// applied already)
+static QRectF mapToNdc(QRhi *rhi, const QMatrix4x4 &projection, const QMatrix4x4 &modelView, const QRectF &r)
+{
+    return (rhi->clipSpaceCorrMatrix().inverted() * projection * modelView).mapRect(r);
+}
+
+// bottom-left based, like QRhiViewport and QRhiScissor
+static QRect ndcToPixels(const QRectF &r, const QSize &outputSizeInPixels)
+{
+    const float w = outputSizeInPixels.width();
+    const float h = outputSizeInPixels.height();
+    const QPoint topLeft(qRound((r.left() + 1.0f) * 0.5f * w), qRound((r.top() + 1.0f) * 0.5f * h));
+    const QPoint bottomRight(qRound((r.right() + 1.0f) * 0.5f * w), qRound((r.bottom() + 1.0f) * 0.5f * h));
+    return QRect(topLeft, bottomRight - QPoint(1, 1));
 }
 
 void RhiRenderNode::prepare()
@@ -64,6 +113,72 @@ void RhiRenderNode::prepare()
     QRhi *rhi = m_window->rhi();
     QRhiResourceUpdateBatch *resourceUpdates = rhi->nextResourceUpdateBatch();
 
+    // This is where things get hairy. QSGRenderNode is used to implement
+    // "inline" rendering, and is not going through an intermediate texture
+    // (unlike minimal_quick_item), and then we try to replicate the behavior of
+    // a proper item. (unlike minimal_quick, that is basically fullscreen, here
+    // it is up to us to deal with taking the item geometry and placement into
+    // account)
+    //
+    // QMatrix4x4 mvp = *projectionMatrix() * *matrix() would give us a matrix
+    // respecting the item geometry, but that's with the scenegraph renderer's
+    // orthographic projection, thus expecting vertices in screen space (as in,
+    // pixels).
+    //
+    // QSGRenderNode is _not_ meant to integrate 3D content generally, unlike
+    // the other approaches. It is rather suited for specific 2D-ish content
+    // when there is a good reason to integrate the custom rendering using this
+    // method instead of using a scene underlay/overlay or going through a
+    // texture. It should be avoided otherwise.
+    //
+    // Here the item's bounding rectangle (as mapped by the projection and
+    // modelview matrices, so translation and scale are respected, rotation
+    // only as far as the bounding rectangle goes) becomes the viewport, and
+    // the clip rectangles set by ancestors with clip: true become the scissor.
+    // Non-rectangular clips (stencil) are not supported.
+    const QRectF itemRect = mapToNdc(rhi, *projectionMatrix(), *matrix(), QRectF(QPointF(0, 0), m_size));
+    QRectF clipRect = itemRect;
+    for (const QSGClipNode *clip = clipList(); clip; clip = clip->clipList()) {
+        const QMatrix4x4 clipMatrix = clip->matrix() ? *clip->matrix() : QMatrix4x4();
+        clipRect &= mapToNdc(rhi, *projectionMatrix(), clipMatrix, clip->clipRect());
+    }
+
+    m_visible = !clipRect.isEmpty();
+    if (!m_visible) {
+        resourceUpdates->release();
+        return;
+    }
+
+    if (m_batched) {
+        if (!m_batch)
+            m_batch = RenderNodeBatch::get(m_window);
+
+        const QSize outputSizeInPixels = renderTarget()->pixelSize();
+        QMatrix4x4 mv;
+        mv.perspective(45.0f, itemRect.width() * outputSizeInPixels.width() / (itemRect.height() * outputSizeInPixels.height()), 0.01f, 1000.0f);
+        mv.translate(0, 0, -4);
+        mv.rotate(m_angle, 0, 1, 0);
+        float instance[RenderNodeBatch::INSTANCE_FLOATS];
+        memcpy(instance, mv.constData(), 16 * sizeof(float));
+        const QPointF center = itemRect.center();
+        instance[16] = center.x();
+        instance[17] = center.y();
+        instance[18] = itemRect.width() * 0.5f;
+        instance[19] = itemRect.height() * 0.5f;
+        instance[20] = clipRect.left();
+        instance[21] = clipRect.top();
+        instance[22] = clipRect.right();
+        instance[23] = clipRect.bottom();
+        m_batch->addInstance(rhi, renderTarget()->renderPassDescriptor(), resourceUpdates, instance);
+    } else {
+        preparePerNode(rhi, resourceUpdates, itemRect, clipRect);
+    }
+
+    commandBuffer()->resourceUpdate(resourceUpdates);
+}
+
+void RhiRenderNode::preparePerNode(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates, const QRectF &itemRect, const QRectF &clipRect)
+{
     if (!m_pipeline) {
         static float vertexData[] = { // Y up, CCW
             0.0f,   0.5f,     1.0f, 0.0f, 0.0f,
@@ -85,6 +200,7 @@ void RhiRenderNode::prepare()
 
         m_pipeline.reset(rhi->newGraphicsPipeline());
         m_pipeline->setDepthTest(true); // unlike other examples
+        m_pipeline->setFlags(QRhiGraphicsPipeline::UsesScissor);
         static auto getShader = [](const QString &name) {
             QFile f(name);
             return f.open(QIODevice::ReadOnly) ? QShader::fromSerialized(f.readAll()) : QShader();
@@ -109,45 +225,35 @@ void RhiRenderNode::prepare()
         resourceUpdates->uploadStaticBuffer(m_vbuf.get(), vertexData);
     }
 
-    // This is where things get hairy. QSGRenderNode is used to implement
-    // "inline" rendering, and is not going through an intermediate texture
-    // (unlike minimal_quick_item), and then we try to replicate the behavior of
-    // a proper item. (unlike minimal_quick, that is basically fullscreen, here
-    // it is up to us to deal with taking the item geometry and placement into
-    // account)
-    //
-    // QMatrix4x4 mvp = *projectionMatrix() * *matrix() would give us a matrix
-    // respecting the item geometry, but that's with the scenegraph renderer's
-    // orthographic projection, thus expecting vertices in screen space (as in,
-    // pixels).
-    //
-    // QSGRenderNode is _not_ meant to integrate 3D content generally, unlike
-    // the other approaches. It is rather suited for specific 2D-ish content
-    // when there is a good reason to integrate the custom rendering using this
-    // method instead of using a scene underlay/overlay or going through a
-    // texture. It should be avoided otherwise.
-
-    // Kind of a bad example. Always render fullscreen, achieving what the
-    // underlay approach in minimal_quick in does, except that here rendering
-    // happens based on the RhiItem's stacking order. Its size, position, etc.
-    // is all ignored.
     const QSize outputSizeInPixels = renderTarget()->pixelSize();
+    const QRect viewport = ndcToPixels(itemRect, outputSizeInPixels);
+    m_viewport = QRhiViewport(viewport.x(), viewport.y(), viewport.width(), viewport.height());
+    const QRect scissor = ndcToPixels(clipRect, outputSizeInPixels);
+    m_scissor = QRhiScissor(scissor.x(), scissor.y(), scissor.width(), scissor.height());
+
     QMatrix4x4 mvp = rhi->clipSpaceCorrMatrix();
-    mvp.perspective(45.0f, outputSizeInPixels.width() / (float) outputSizeInPixels.height(), 0.01f, 1000.0f);
+    mvp.perspective(45.0f, viewport.width() / (float) viewport.height(), 0.01f, 1000.0f);
     mvp.translate(0, 0, -4);
     mvp.rotate(m_angle, 0, 1, 0);
 
     resourceUpdates->updateDynamicBuffer(m_ubuf.get(), 0, 64, mvp.constData());
-    commandBuffer()->resourceUpdate(resourceUpdates);
 }
 
 void RhiRenderNode::render(const RenderState *)
 {
+    if (!m_visible)
+        return;
+
     QRhiCommandBuffer *cb = commandBuffer();
-    const QSize outputSizeInPixels = renderTarget()->pixelSize();
+
+    if (m_batched) {
+        m_batch->render(cb, renderTarget()->pixelSize());
+        return;
+    }
 
     cb->setGraphicsPipeline(m_pipeline.get());
-    cb->setViewport(QRhiViewport(0, 0, outputSizeInPixels.width(), outputSizeInPixels.height()));
+    cb->setViewport(m_viewport);
+    cb->setScissor(m_scissor);
     cb->setShaderResources();
     const QRhiCommandBuffer::VertexInput vbufBinding(m_vbuf.get(), 0);
     cb->setVertexInput(0, 1, &vbufBinding);
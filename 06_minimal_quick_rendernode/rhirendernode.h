@@ -9,6 +9,7 @@
 #include <rhi/qrhi.h>
 
 class RhiItemRenderer;
+class RenderNodeBatch;
 
 class RhiItem : public QQuickItem
 {
@@ -33,21 +34,35 @@ private:
 class RhiRenderNode : public QSGRenderNode
 {
 public:
-    RhiRenderNode(QQuickWindow *window) : m_window(window) { }
+    RhiRenderNode(QQuickWindow *window);
 
     void prepare() override;
     void render(const RenderState *state) override;
     void releaseResources() override;
     RenderingFlags flags() const override;
     QSGRenderNode::StateFlags changedStates() const override;
+    QRectF rect() const override;
+
+    // Draw all nodes in a window with one instanced draw call, see
+    // RenderNodeBatch. Applies to nodes created afterwards.
+    static void setBatchingEnabled(bool enable);
+    static bool isBatchingEnabled();
 
 private:
+    void preparePerNode(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates, const QRectF &itemRect, const QRectF &clipRect);
+
     QQuickWindow *m_window;
+    bool m_batched;
+    std::shared_ptr<RenderNodeBatch> m_batch;
+    QRhiViewport m_viewport;
+    QRhiScissor m_scissor;
+    bool m_visible = false;
     std::unique_ptr<QRhiBuffer> m_vbuf;
     std::unique_ptr<QRhiBuffer> m_ubuf;
     std::unique_ptr<QRhiShaderResourceBindings> m_srb;
     std::unique_ptr<QRhiGraphicsPipeline> m_pipeline;
     float m_angle = 0.0f;
+    QSizeF m_size;
 
     friend class RhiItem;
 };
@@ -0,0 +1,31 @@
+import QtQuick
+import TestApp
+
+// Many RhiItems, see --stress
+Item {
+    id: root
+    width: 1280
+    height: 720
+
+    property int itemCount: 200
+    readonly property int columns: Math.ceil(Math.sqrt(itemCount * width / height))
+
+    // clips the bottom row partially, so that the scissor is exercised too
+    Item {
+        anchors.fill: parent
+        anchors.margins: 20
+        clip: true
+
+        Grid {
+            columns: root.columns
+            Repeater {
+                model: root.itemCount
+                RhiItem {
+                    width: root.width / root.columns
+                    height: width
+                    NumberAnimation on triangleRotation { from: index * 7; to: index * 7 + 360; duration: 1500; loops: -1 }
+                }
+            }
+        }
+    }
+}